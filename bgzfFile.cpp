@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Read BGZF-compressed files
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Implementation of a BGZF (`bgzip`) file reader with random access by virtual offset. Blocks are inflated with zlib.
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+
+#include <zlib.h>
+
+#include "bgzfFile.hpp"
+#include "mappedFile.hpp"
+
+using std::string;
+using std::vector;
+using std::fstream;
+using std::ios;
+
+using namespace BayesicSpace;
+
+/// Size of the fixed part of a gzip block header
+static const size_t gzipHeaderSize = 12;
+/// Size of the gzip block footer (CRC32 and uncompressed size)
+static const size_t gzipFooterSize = 8;
+/// Largest decompressed block size
+static const size_t maxBlockSize   = 65536;
+
+/** \brief Find the BGZF block size field
+ *
+ * Looks for the `BC` sub-field in the gzip extra field.
+ *
+ * \param[in] header start of the block
+ * \param[in] nBytes bytes available from the start of the block
+ * \param[out] blockSize total compressed block size
+ * \return false if this is not a BGZF block header
+ */
+static bool bgzfBlockSize(const unsigned char *header, const size_t &nBytes, size_t &blockSize){
+	if ( (nBytes < gzipHeaderSize) || (header[0] != 31) || (header[1] != 139) || (header[2] != 8) || ( (header[3] & 4) == 0 ) ) {
+		return false;
+	}
+	const size_t extraLength = static_cast<size_t>(header[10]) | ( static_cast<size_t>(header[11]) << 8 );
+	if (nBytes < gzipHeaderSize + extraLength) {
+		return false;
+	}
+	size_t iExtra = gzipHeaderSize;
+	while (iExtra + 4 <= gzipHeaderSize + extraLength) {
+		const size_t fieldLength = static_cast<size_t>(header[iExtra + 2]) | ( static_cast<size_t>(header[iExtra + 3]) << 8 );
+		if ( (header[iExtra] == 'B') && (header[iExtra + 1] == 'C') && (fieldLength == 2) ) {
+			blockSize = ( static_cast<size_t>(header[iExtra + 4]) | ( static_cast<size_t>(header[iExtra + 5]) << 8 ) ) + 1;
+			return true;
+		}
+		iExtra += 4 + fieldLength;
+	}
+	return false;
+}
+
+BGZFfile::BGZFfile(const string &fileName) : file_(fileName), block_(maxBlockSize), blockStart_{0}, nextBlock_{0}, blockSize_{0}, inBlock_{0} {
+	loadBlock_(0);
+}
+
+BGZFfile::BGZFfile(BGZFfile &&in) : file_{std::move(in.file_)}, block_{std::move(in.block_)}, blockStart_{in.blockStart_}, nextBlock_{in.nextBlock_}, blockSize_{in.blockSize_}, inBlock_{in.inBlock_} {
+	in.blockStart_ = 0;
+	in.nextBlock_  = 0;
+	in.blockSize_  = 0;
+	in.inBlock_    = 0;
+}
+
+BGZFfile &BGZFfile::operator=(BGZFfile &&in){
+	if (&in != this) {
+		file_       = std::move(in.file_);
+		block_      = std::move(in.block_);
+		blockStart_ = in.blockStart_;
+		nextBlock_  = in.nextBlock_;
+		blockSize_  = in.blockSize_;
+		inBlock_    = in.inBlock_;
+
+		in.blockStart_ = 0;
+		in.nextBlock_  = 0;
+		in.blockSize_  = 0;
+		in.inBlock_    = 0;
+	}
+	return *this;
+}
+
+bool BGZFfile::isBGZF(const string &fileName){
+	fstream inFile;
+	inFile.open(fileName.c_str(), ios::in | ios::binary);
+	if ( !inFile.is_open() ) {
+		return false;
+	}
+	char header[gzipHeaderSize + 6];
+	inFile.read( header, sizeof(header) );
+	const size_t nRead = static_cast<size_t>( inFile.gcount() );
+	inFile.close();
+	size_t blockSize = 0;
+	return bgzfBlockSize(reinterpret_cast<const unsigned char*>(header), nRead, blockSize);
+}
+
+bool BGZFfile::getline(string &line){
+	line.clear();
+	if ( !fillBlock_() ) {
+		return false;
+	}
+	while ( fillBlock_() ) {
+		const char *start   = block_.data() + inBlock_;
+		const size_t nLeft  = blockSize_ - inBlock_;
+		const char *lineEnd = static_cast<const char*>( memchr(start, '\n', nLeft) );
+		if (lineEnd != nullptr) {
+			const size_t length = static_cast<size_t>(lineEnd - start);
+			line.append(start, length);
+			inBlock_ += length + 1;
+			return true;
+		}
+		line.append(start, nLeft);
+		inBlock_ = blockSize_;
+	}
+	return true; // last line without a line end
+}
+
+size_t BGZFfile::read(char *buffer, const size_t &nBytes){
+	size_t nRead = 0;
+	while ( (nRead < nBytes) && fillBlock_() ) {
+		const size_t nCopy = std::min(nBytes - nRead, blockSize_ - inBlock_);
+		memcpy(buffer + nRead, block_.data() + inBlock_, nCopy);
+		nRead    += nCopy;
+		inBlock_ += nCopy;
+	}
+	return nRead;
+}
+
+void BGZFfile::seek(const uint64_t &virtualOffset){
+	const size_t blockStart = static_cast<size_t>(virtualOffset >> 16);
+	const size_t inBlock    = static_cast<size_t>(virtualOffset & 0xFFFF);
+	if ( (blockStart != blockStart_) || (blockSize_ == 0) ) {
+		loadBlock_(blockStart);
+	}
+	if (inBlock > blockSize_) {
+		throw string("ERROR: virtual offset past the end of its BGZF block; the index may not match the file");
+	}
+	inBlock_ = inBlock;
+}
+
+void BGZFfile::loadBlock_(const size_t &offset){
+	blockStart_ = offset;
+	inBlock_    = 0;
+	blockSize_  = 0;
+	if ( offset >= file_.size() ) {
+		nextBlock_ = offset;
+		return;
+	}
+	const unsigned char *header = reinterpret_cast<const unsigned char*>(file_.data() + offset);
+	size_t compressedSize       = 0;
+	if ( !bgzfBlockSize(header, file_.size() - offset, compressedSize) || (offset + compressedSize > file_.size()) ) {
+		throw string("ERROR: malformed BGZF block; the file may be truncated or not compressed with bgzip");
+	}
+	const size_t extraLength = static_cast<size_t>(header[10]) | ( static_cast<size_t>(header[11]) << 8 );
+	const size_t dataStart   = gzipHeaderSize + extraLength;
+	if (compressedSize < dataStart + gzipFooterSize) {
+		throw string("ERROR: BGZF block too short");
+	}
+	const unsigned char *footer = header + compressedSize - 4;
+	const size_t expectedSize   = static_cast<size_t>(footer[0]) | ( static_cast<size_t>(footer[1]) << 8 ) | ( static_cast<size_t>(footer[2]) << 16 ) | ( static_cast<size_t>(footer[3]) << 24 );
+	if (expectedSize > maxBlockSize) {
+		throw string("ERROR: BGZF block decompresses to more than 64 kb");
+	}
+	nextBlock_ = offset + compressedSize;
+	if (expectedSize == 0) { // empty blocks, such as the end-of-file marker
+		return;
+	}
+
+	z_stream zStream;
+	memset( &zStream, 0, sizeof(zStream) );
+	if (inflateInit2(&zStream, -15) != Z_OK) { // raw deflate stream
+		throw string("ERROR: cannot initialize zlib");
+	}
+	zStream.next_in   = const_cast<Bytef*>(header + dataStart);
+	zStream.avail_in  = static_cast<uInt>(compressedSize - dataStart - gzipFooterSize);
+	zStream.next_out  = reinterpret_cast<Bytef*>( block_.data() );
+	zStream.avail_out = static_cast<uInt>( block_.size() );
+	const int status  = inflate(&zStream, Z_FINISH);
+	inflateEnd(&zStream);
+	if ( (status != Z_STREAM_END) || (zStream.total_out != expectedSize) ) {
+		throw string("ERROR: failed to decompress a BGZF block");
+	}
+	blockSize_ = expectedSize;
+}
+
+bool BGZFfile::fillBlock_(){
+	while (inBlock_ == blockSize_) {
+		if ( nextBlock_ >= file_.size() ) {
+			return false;
+		}
+		loadBlock_(nextBlock_);
+	}
+	return true;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Read BGZF-compressed files
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Class definitions and interface documentation for reading block-compressed (BGZF, as written by `bgzip`) files with random access by virtual offset.
+ *
+ */
+
+#ifndef bgzfFile_hpp
+#define bgzfFile_hpp
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "mappedFile.hpp"
+
+using std::string;
+using std::vector;
+
+namespace BayesicSpace {
+	/** \brief BGZF file reader
+	 *
+	 * Reads a BGZF file (a series of independently deflated gzip blocks of at most 64 kb each) through a memory mapping, decompressing one block at a time.
+	 * Positions in the file are BGZF virtual offsets: the compressed offset of a block shifted left by 16 bits, combined with the offset within the decompressed block.
+	 * These are the offsets stored in tabix and CSI indexes.
+	 */
+	class BGZFfile {
+		public:
+			/** \brief Default constructor */
+			BGZFfile() : blockStart_{0}, nextBlock_{0}, blockSize_{0}, inBlock_{0} {};
+			/** \brief File name constructor
+			 *
+			 * Maps the file and decompresses the first block.
+			 *
+			 * \param[in] fileName file name
+			 */
+			BGZFfile(const string &fileName);
+
+			/** \brief Destructor */
+			~BGZFfile(){};
+			/// Copy constructor
+			BGZFfile(const BGZFfile &in) = delete;
+			/// Move constructor
+			BGZFfile(BGZFfile &&in);
+			/// Copy assignment
+			BGZFfile &operator=(const BGZFfile &in) = delete;
+			/// Move assignment
+			BGZFfile &operator=(BGZFfile &&in);
+
+			/** \brief Test for BGZF compression
+			 *
+			 * Checks the gzip magic number and the BGZF extra field of the first block.
+			 *
+			 * \param[in] fileName file name
+			 * \return true if the file is BGZF-compressed
+			 */
+			static bool isBGZF(const string &fileName);
+			/** \brief Read a line
+			 *
+			 * Reads up to the next line end, which is discarded. Lines can span blocks.
+			 *
+			 * \param[out] line the line
+			 * \return false if there is nothing left to read
+			 */
+			bool getline(string &line);
+			/** \brief Read bytes
+			 *
+			 * \param[out] buffer buffer to fill
+			 * \param[in] nBytes number of bytes to read
+			 * \return number of bytes read (fewer than requested at the end of the file)
+			 */
+			size_t read(char *buffer, const size_t &nBytes);
+			/** \brief Current virtual offset
+			 *
+			 * \return virtual offset of the next byte to be read
+			 */
+			uint64_t tell() const { return (static_cast<uint64_t>(blockStart_) << 16) | static_cast<uint64_t>(inBlock_); };
+			/** \brief Move to a virtual offset
+			 *
+			 * \param[in] virtualOffset virtual offset (e.g., from an index)
+			 */
+			void seek(const uint64_t &virtualOffset);
+		private:
+			/// The memory-mapped compressed file
+			MappedFile file_;
+			/// Decompressed current block
+			vector<char> block_;
+			/// Compressed offset of the current block
+			size_t blockStart_;
+			/// Compressed offset of the next block
+			size_t nextBlock_;
+			/// Decompressed size of the current block
+			size_t blockSize_;
+			/// Position of the next byte in the decompressed block
+			size_t inBlock_;
+
+			/** \brief Decompress a block
+			 *
+			 * \param[in] offset compressed offset of the block
+			 */
+			void loadBlock_(const size_t &offset);
+			/** \brief Make sure there are bytes to read
+			 *
+			 * Moves on to the next non-empty block if the current one is used up.
+			 *
+			 * \return false at the end of the file
+			 */
+			bool fillBlock_();
+	};
+}
+
+#endif /* bgzfFile_hpp */
@@ -29,6 +29,7 @@
  * -q query file name (binding locations or four-fold sites)
  * -a .axt file name
  * -o output file name
+ * -t number of threads (optional, default 1)
  *
  */
 
@@ -36,11 +37,12 @@
 #include <vector>
 #include <unordered_map>
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include <cctype>
 
 #include "parseAXT.hpp"
+#include "queryFile.hpp"
+#include "mappedFile.hpp"
+#include "siteRecords.hpp"
+#include "tsvWriter.hpp"
 #include "utilities.hpp"
 
 using namespace BayesicSpace;
@@ -48,10 +50,6 @@ using std::vector;
 using std::unordered_map;
 using std::cerr;
 using std::endl;
-using std::fstream;
-using std::ofstream;
-using std::stringstream;
-using std::ios;
 
 using namespace BayesicSpace;
 
@@ -67,138 +65,73 @@ int main(int argc, char *argv[]){
 			throw string("Must specify output file name with flag -o");
 		}
 
-		ParseAXT axt(clInfo['a']);
-
-		string qLine;
-		vector<string> chrNams;
-		vector<uint64_t> positions;
-
-		fstream queryFile;
-		queryFile.open(clInfo['q'].c_str(), ios::in);
-
-		// process first uncommented non-empty line and see how many fields we are dealing with
-		while ( getline(queryFile, qLine) ) {
-			if ( qLine.size() && (qLine[0] != '#') ){
-				break;
+		size_t nThreads = 1;
+		if ( !clInfo['t'].empty() ) {
+			nThreads = strtoul(clInfo['t'].c_str(), NULL, 0);
+			if (nThreads == 0) {
+				throw string("Number of threads (flag -t) must be a positive integer");
 			}
 		}
-		if ( queryFile.eof() ){
-			queryFile.close();
-			throw string("Query file has no uncommented non-empty lines");
-		}
-		stringstream firstLnSS(qLine);
-		vector<string> fields;
-		string firstValue;
-		while(firstLnSS >> firstValue){
-			fields.push_back(firstValue);
+
+		ParseAXT axt(clInfo['a']);
+
+		QueryFile queries(clInfo['q']);
+		vector<uint32_t> axtIDs;
+		for (auto &eachName : queries.chromosomeNames()) {
+			axtIDs.push_back( axt.chromosomeID(eachName) );
 		}
-		if (fields.size() < 2) {
-			queryFile.close();
-			throw string("Query file should have at least two white-space separated fields");
-		} else if (fields.size() == 2){ // positions file
-			if ( isdigit(fields[1][0]) ){
-				if (fields[0].size() <= 2){
-					fields[0] = "chr" + fields[0];
-				}
-				chrNams.push_back(fields[0]);
-				positions.push_back( strtoul(fields[1].c_str(), NULL, 0) );
+		queries.renumber(axtIDs);
+
+		if ( !queries.ranges() ) { // positions file
+			// the lengths are only known after all sites are processed, so stream the sites to a temporary file next to the output and copy them after the meta-data
+			// the temporary file is removed when it goes out of scope, also if an error is thrown
+			const TemporaryFile sitesTemp(clInfo['o']);
+			vector<uint64_t> lengths;
+			DivergedSiteFile sitesFile( sitesTemp.name(), axt.chromosomeNames() );
+			if (nThreads > 1) {
+				axt.getDivergedSites(queries.chromosomes(), queries.positions(), sitesFile, lengths, nThreads);
+			} else {
+				axt.getDivergedSites(queries.chromosomes(), queries.positions(), sitesFile, lengths);
 			}
-			while( getline(queryFile, qLine) ){
-				if ( qLine.empty() || (qLine[0] == '#') ){
-					continue;
-				}
-				stringstream lnSS(qLine);
-				vector<string> fields;
-				string value;
-				while(lnSS >> value){
-					fields.push_back(value);
-				}
-				if (fields.size() != 2) {
-					queryFile.close();
-					string error = "Line " + qLine + " does not have two fields in a positions query file";
-					throw error;
-				} else if ( !isdigit(fields[1][0]) ){
-					queryFile.close();
-					string error = fields[1] + " is not a numerical value in the position field";
-					throw error;
-				}
-				if (fields[0].size() <= 2){
-					fields[0] = "chr" + fields[0];
-				}
-				chrNams.push_back(fields[0]);
-				positions.push_back( strtoul(fields[1].c_str(), NULL, 0) );
-			}
-			queryFile.close();
-
-			vector<string> divergedSites;
-			unordered_map<string, uint64_t> lengths;
-			axt.getDivergedSites(chrNams, positions, divergedSites, lengths);
+			sitesFile.close();
 
-			fstream outFile;
-			outFile.open(clInfo['o'].c_str(), ios::out | ios::trunc);
+			TSVwriter outFile(clInfo['o']);
 
 			// first put meta-data (total number of good sites) in commented lines at the beginning of the file
-			for (auto &c : lengths) {
-				outFile << "#\t" << c.first << "\t" << c.second << endl;
+			for (uint32_t iChr = 0; iChr < lengths.size(); iChr++) {
+				if (lengths[iChr] == 0) { // no covered query sites on this chromosome
+					continue;
+				}
+				outFile.putText("#\t");
+				outFile.putText( axt.chromosomeName(iChr) );
+				outFile.tab();
+				outFile.putUnsigned(lengths[iChr]);
+				outFile.newLine();
 			}
 
 			// now output the results
-			outFile << "chr\tposition\tprNuc\talNuc\tsameCHR\tgoodQual" << endl;
-			for (auto &ds : divergedSites) {
-				outFile << ds << endl;
+			outFile.putText("chr\tposition\tprNuc\talNuc\tsameCHR\tgoodQual\n");
+			{
+				MappedFile sitesIn( sitesTemp.name() );
+				outFile.putBytes( sitesIn.data(), sitesIn.size() );
 			}
 			outFile.close();
 		} else { // ranges file
-			fstream outFile;
-			outFile.open(clInfo['o'].c_str(), ios::out | ios::trunc);
-			outFile << "peakID\trealLen\tchr\tposition\tprNuc\talNuc\tsameCHR\tgoodQual" << endl;
-
-			uint32_t peakID = 1;
-			vector<string> divergedSites;
-			uint64_t length = 0;
-			if ( isdigit(fields[1][0]) && isdigit(fields[2][0]) ){
-				if (fields[0].size() <= 2){
-					fields[0] = "chr" + fields[0];
-				}
-				chrNams.push_back(fields[0]);
-				positions.push_back( strtoul(fields[1].c_str(), NULL, 0) );
-				axt.getDivergedSites(fields[0], strtoul(fields[1].c_str(), NULL, 0), strtoul(fields[2].c_str(), NULL, 0), divergedSites, length);
-				for (auto &ds : divergedSites) {
-					outFile << "P" << peakID << "\t" << length << "\t" << ds << endl;
-				}
-				peakID++;
-			}
-			while( getline(queryFile, qLine) ){
-				stringstream lnSS(qLine);
-				if ( qLine.empty() || (qLine[0] == '#') ){
-					continue;
-				}
-				vector<string> fields;
-				string value;
-				while(lnSS >> value){
-					fields.push_back(value);
-				}
-				if (fields.size() < 3) {
-					outFile.close();
-					queryFile.close();
-					string error = "Line " + qLine + " has fewer than three fields in a ranges query file";
-					throw error;
-				} else if ( !isdigit(fields[1][0]) || !isdigit(fields[2][0]) ){
-					outFile.close();
-					queryFile.close();
-					string error = "Field " + fields[1] + " or " + fields[2] + " is not numeric in the ranges query file";
-					throw error;
-				}
-				if (fields[0].size() <= 2){
-					fields[0] = "chr" + fields[0];
-				}
-				axt.getDivergedSites(fields[0], strtoul(fields[1].c_str(), NULL, 0), strtoul(fields[2].c_str(), NULL, 0), divergedSites, length);
-				for (auto &ds : divergedSites) {
-					outFile << "P" << peakID << "\t" << length << "\t" << ds << endl;
-				}
-				peakID++;
+			DivergedSiteFile outFile( clInfo['o'], axt.chromosomeNames() );
+			outFile.putLine("peakID\trealLen\tchr\tposition\tprNuc\talNuc\tsameCHR\tgoodQual");
+
+			// range lengths are counted from the site bit vectors; all ranges are swept at once for the sites, so overlapping stretches are only read once
+			vector<uint64_t> lengths;
+			vector<uint64_t> nDiverged;
+			axt.countSites(queries.chromosomes(), queries.starts(), queries.ends(), lengths, nDiverged);
+			// sites are written as they are found, each line starting with the peak ID and length
+			outFile.setQueryPrefix("P");
+			outFile.setQueryLengths(lengths);
+			if (nThreads > 1) {
+				axt.getDivergedSites(queries.chromosomes(), queries.starts(), queries.ends(), outFile, nThreads);
+			} else {
+				axt.getDivergedSites(queries.chromosomes(), queries.starts(), queries.ends(), outFile);
 			}
-			queryFile.close();
 			outFile.close();
 		}
 		exit(0);
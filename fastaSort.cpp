@@ -40,7 +40,9 @@
 #include <cctype>
 
 #include "utilities.hpp"
+#include "tsvWriter.hpp"
 
+using namespace BayesicSpace;
 using std::vector;
 using std::map;
 using std::unordered_map;
@@ -154,51 +156,63 @@ int main(int argc, char *argv[]){
 	}
 	fastaIn.close();
 	// now save the results, checking if there are duplicate FBgn; save the longest one if there are duplicates
-	fstream fastaOut;
-	fastaOut.open(clInfo['o'].c_str(), ios::out|ios::trunc);
-	for (auto &chr : outData) {
-		string prevFBgn;
-		uint64_t prevEndPos;
-		vector<string> prevRecord(2);
-		// sorting ensures that they are one after another (except possibly in the edge case when an opposite strand ovelapping gene terminates between start sites)
-		for (auto &r : chr.second) {
-			if ( prevRecord[0].empty() ) { // this should be true only once (for the first record). May need optimizing.
-				getFBgnLastPos(r.second[0], prevFBgn, prevEndPos);
-				prevRecord = move(r.second);
-			} else {
-				string curFBgn;
-				uint64_t curEndPos;
-				getFBgnLastPos(r.second[0], curFBgn, curEndPos);
-				if (curFBgn != prevFBgn) {
-					if (r.first == chr.second.end()->first) { // otherwise the last record is never output
-						fastaOut << prevRecord[0] << endl;
-						fastaOut << prevRecord[1] << endl;
-						fastaOut << r.second[0] << endl;
-						fastaOut << r.second[1] << endl;
-					} else if (curEndPos <= prevEndPos) {
-						continue;
-					} else {
-						fastaOut << prevRecord[0] << endl;
-						fastaOut << prevRecord[1] << endl;
-						prevFBgn   = move(curFBgn);
-						prevEndPos = curEndPos;
-						prevRecord = move(r.second);
-					}
+	try {
+		TSVwriter fastaOut(clInfo['o']);
+		for (auto &chr : outData) {
+			string prevFBgn;
+			uint64_t prevEndPos;
+			vector<string> prevRecord(2);
+			// sorting ensures that they are one after another (except possibly in the edge case when an opposite strand ovelapping gene terminates between start sites)
+			for (auto &r : chr.second) {
+				if ( prevRecord[0].empty() ) { // this should be true only once (for the first record). May need optimizing.
+					getFBgnLastPos(r.second[0], prevFBgn, prevEndPos);
+					prevRecord = move(r.second);
 				} else {
-					if (prevRecord[1].size() < r.second[1].size()) {
-						if (r.first == chr.second.end()->first) {
-							fastaOut << r.second[0] << endl;
-							fastaOut << r.second[1] << endl;
+					string curFBgn;
+					uint64_t curEndPos;
+					getFBgnLastPos(r.second[0], curFBgn, curEndPos);
+					if (curFBgn != prevFBgn) {
+						if (r.first == chr.second.end()->first) { // otherwise the last record is never output
+							fastaOut.putText(prevRecord[0]);
+							fastaOut.newLine();
+							fastaOut.putText(prevRecord[1]);
+							fastaOut.newLine();
+							fastaOut.putText(r.second[0]);
+							fastaOut.newLine();
+							fastaOut.putText(r.second[1]);
+							fastaOut.newLine();
+						} else if (curEndPos <= prevEndPos) {
+							continue;
 						} else {
-							prevRecord = move(r.second);
+							fastaOut.putText(prevRecord[0]);
+							fastaOut.newLine();
+							fastaOut.putText(prevRecord[1]);
+							fastaOut.newLine();
+							prevFBgn   = move(curFBgn);
 							prevEndPos = curEndPos;
+							prevRecord = move(r.second);
+						}
+					} else {
+						if (prevRecord[1].size() < r.second[1].size()) {
+							if (r.first == chr.second.end()->first) {
+								fastaOut.putText(r.second[0]);
+								fastaOut.newLine();
+								fastaOut.putText(r.second[1]);
+								fastaOut.newLine();
+							} else {
+								prevRecord = move(r.second);
+								prevEndPos = curEndPos;
+							}
 						}
 					}
 				}
 			}
 		}
+		fastaOut.close();
+	} catch(string error) {
+		cerr << error << endl;
+		exit(3);
 	}
-	fastaOut.close();
 }
 
 
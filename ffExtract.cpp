@@ -33,6 +33,7 @@
 #include <sstream>
 #include <cstdlib>
 #include <cctype>
+#include <algorithm>
 #include <system_error>
 
 #include "ffExtract.hpp"
@@ -48,7 +49,77 @@ using std::ios;
 
 using namespace BayesicSpace;
 
-FFextract::FFextract(const string &fastaName, const string &logName) : header_{""}, sequence_{""}, end_{0}, chr_{""}, fbgn_{""}, delStart_{0}, delLength_{0} {
+void ExonMap::addExon(const uint64_t &start, const uint64_t &end){
+	firstPositions_.push_back(complemented_ ? end : start);
+	offsets_.push_back(offsets_.back() + static_cast<size_t>(end - start) + 1);
+}
+
+uint64_t ExonMap::position(const size_t &offset) const {
+	const size_t exon      = static_cast<size_t>(std::upper_bound(offsets_.begin(), offsets_.end(), offset) - offsets_.begin()) - 1;
+	const uint64_t inExon  = offset - offsets_[exon];
+	return ( complemented_ ? firstPositions_[exon] - inExon : firstPositions_[exon] + inExon );
+}
+
+size_t ExonMap::countAtLeast(const uint64_t &position) const {
+	size_t count = 0;
+	for (size_t iExon = 0; iExon < firstPositions_.size(); iExon++) {
+		const uint64_t length = offsets_[iExon + 1] - offsets_[iExon];
+		const uint64_t low    = ( complemented_ ? firstPositions_[iExon] - length + 1 : firstPositions_[iExon] );
+		const uint64_t high   = low + length - 1;
+		if (position <= low) {
+			count += length;
+		} else if (position <= high) {
+			count += high - position + 1;
+		}
+	}
+	return count;
+}
+
+size_t ExonMap::countAtMost(const uint64_t &position) const {
+	size_t count = 0;
+	for (size_t iExon = 0; iExon < firstPositions_.size(); iExon++) {
+		const uint64_t length = offsets_[iExon + 1] - offsets_[iExon];
+		const uint64_t low    = ( complemented_ ? firstPositions_[iExon] - length + 1 : firstPositions_[iExon] );
+		const uint64_t high   = low + length - 1;
+		if (position >= high) {
+			count += length;
+		} else if (position >= low) {
+			count += position - low + 1;
+		}
+	}
+	return count;
+}
+
+void ExonMap::trimFront(const size_t &length){
+	if ( length >= offsets_.back() ) {
+		reset(complemented_);
+		return;
+	}
+	// first exon to keep is the one that contains the new first nucleotide
+	const size_t exon = static_cast<size_t>(std::upper_bound(offsets_.begin(), offsets_.end(), length) - offsets_.begin()) - 1;
+	const uint64_t inExon = length - offsets_[exon];
+	firstPositions_[exon] = ( complemented_ ? firstPositions_[exon] - inExon : firstPositions_[exon] + inExon );
+	firstPositions_.erase( firstPositions_.begin(), firstPositions_.begin() + static_cast<std::ptrdiff_t>(exon) );
+	offsets_.erase( offsets_.begin(), offsets_.begin() + static_cast<std::ptrdiff_t>(exon) );
+	for (auto &o : offsets_) {
+		o = ( o > length ? o - length : 0 );
+	}
+}
+
+void ExonMap::trimBack(const size_t &length){
+	if ( length >= offsets_.back() ) {
+		reset(complemented_);
+		return;
+	}
+	const size_t newSize = offsets_.back() - length;
+	// number of exons that start before the new end
+	const size_t nExons  = static_cast<size_t>(std::lower_bound(offsets_.begin(), offsets_.end(), newSize) - offsets_.begin());
+	firstPositions_.resize(nExons);
+	offsets_.resize(nExons + 1);
+	offsets_.back() = newSize;
+}
+
+FFextract::FFextract(const string &fastaName, const string &logName) : header_{""}, sequence_{""}, end_{0}, chr_{GenomeDictionary::missing}, fbgn_{""}, delStart_{0}, delLength_{0}, annotate_{false} {
 	if (fastaFile_.is_open()) {
 		fastaFile_.close();
 	}
@@ -70,7 +141,7 @@ FFextract::FFextract(const string &fastaName, const string &logName) : header_{"
 	// load the first record
 	getline(fastaFile_, header_);
 	parseHeader_(positions_, chr_, fbgn_);
-	end_ = ( ( positions_[0] < positions_.back() ) ? positions_.back() : positions_[0] );
+	end_ = ( ( positions_.front() < positions_.back() ) ? positions_.back() : positions_.front() );
 	getline(fastaFile_, sequence_);
 }
 
@@ -83,7 +154,7 @@ FFextract::~FFextract(){
 	}
 }
 
-void FFextract::extractFFsites(vector<string> &positionList){
+void FFextract::extractFFsites(vector<FFsite> &positionList){
 	while ( !fastaFile_.eof() ){
 		getNextRecord_();
 	}
@@ -93,7 +164,13 @@ void FFextract::extractFFsites(vector<string> &positionList){
 	positionList = move(ffSites_);
 }
 
-void FFextract::parseHeader_(vector<uint64_t> &positions, string &chr, string &fbgn){
+void FFextract::extractSites(vector<FFsite> &ffSiteList, vector<CodingSite> &codingSiteList){
+	annotate_ = true;
+	extractFFsites(ffSiteList);
+	codingSiteList = move(codingSites_);
+}
+
+void FFextract::parseHeader_(ExonMap &positions, uint32_t &chr, string &fbgn){
 	positions.clear();
 	stringstream hSS(header_);
 	string field;
@@ -104,27 +181,21 @@ void FFextract::parseHeader_(vector<uint64_t> &positions, string &chr, string &f
 			if (field.compare(0, 4, "Scf_") == 0) {
 				field.erase(0, 4);
 			}
-			if ( (field[0] == 'X') || (field[0] == '4') ) {
-				chr = field[0];
-				field.erase(0, 2);
-			} else if ( (field[0] == '3') || (field[0] == '2') ) {
-				chr.assign(field, 0, 2);
-				field.erase(0,3);
-			} else {
-				string error("ERROR: unkown chromosome ");
-				size_t col = field.find_first_of(':');
-				if (col > 0) {
-					col--;
-				}
-				error += field.substr(0, col);
+			const size_t col = field.find_first_of(':');
+			if ( (col == 0) || (col == string::npos) ) {
+				string error("ERROR: no chromosome name in the loc field ");
+				error += field;
 				throw error;
 			}
+			chr = genome_.intern( field.substr(0, col) );
+			field.erase(0, col + 1);
 			field.erase(field.end()-1);
 			if (field[0] == 'c') { // the only way this occurs is when complement() is specified
 				complemented = true;
 				field.erase(0, 11);
 				field.erase(field.end()-1);
 			}
+			positions.reset(complemented);
 			if (isdigit(field[0])) { // only one exon, no complement
 				if (field.size() <= 2) {
 					string error("Cannot parse postion range in header\n");
@@ -141,19 +212,7 @@ void FFextract::parseHeader_(vector<uint64_t> &positions, string &chr, string &f
 					error += "\n";
 					throw error;
 				}
-				if (complemented) {
-					while (end != start){
-						positions.push_back(end);
-						end--;
-					}
-					positions.push_back(start); // necessary to top off
-				} else {
-					while (start != end){
-						positions.push_back(start);
-						start++;
-					}
-					positions.push_back(end); // necessary to top off
-				}
+				positions.addExon(start, end);
 			} else if (field[0] == 'j') { //  there is a join
 				field.erase(0, 5);
 				field.erase(field.end()-1);
@@ -174,11 +233,7 @@ void FFextract::parseHeader_(vector<uint64_t> &positions, string &chr, string &f
 							error += "\n";
 							throw error;
 						}
-						while (end != start){
-							positions.push_back(end);
-							end--;
-						}
-						positions.push_back(start); // necessary to top off
+						positions.addExon(start, end);
 					}
 				} else {
 					for (auto it = ranges.begin(); it != ranges.end(); ++it) {
@@ -191,11 +246,7 @@ void FFextract::parseHeader_(vector<uint64_t> &positions, string &chr, string &f
 							error += "\n";
 							throw error;
 						}
-						while (start != end){
-							positions.push_back(start);
-							start++;
-						}
-						positions.push_back(end); // necessary to top off
+						positions.addExon(start, end);
 					}
 				}
 			} else {
@@ -222,59 +273,45 @@ void FFextract::getNextRecord_(){
 	while(getline(fastaFile_, curLine)){
 		if (curLine[0] == '>') {
 			header_ = move(curLine);
-			vector<uint64_t> curPos;
-			string curChr;
+			ExonMap curPos;
+			uint32_t curChr = GenomeDictionary::missing;
 			string curFBgn;
 			parseHeader_(curPos, curChr, curFBgn);
 			if (curChr != chr_) { // new chromosome; no need to check for overlap
-				logFile_ << "Switched from chromosome " << chr_ << " to " << curChr << " at FBgn" << curFBgn << endl;
+				logFile_ << "Switched from chromosome " << genome_.name(chr_) << " to " << genome_.name(curChr) << " at FBgn" << curFBgn << endl;
 				getFFsites_(); // extracting from the previous record
-				positions_ = move(curPos);
-				end_       = ( ( positions_[0] < positions_.back() ) ? positions_.back() : positions_[0] );
-				chr_       = move(curChr);
+				positions_ = std::move(curPos);
+				end_       = ( ( positions_.front() < positions_.back() ) ? positions_.back() : positions_.front() );
+				chr_       = curChr;
 				fbgn_      = move(curFBgn);
 				delLength_ = 0;
 				continue;
 			} else if ( positions_.empty() ) {
 				logFile_ << "Previous record empty at FBgn" << curFBgn << endl;
-				positions_ = move(curPos);
-				end_       = ( ( positions_[0] < positions_.back() ) ? positions_.back() : positions_[0] );
-				chr_       = move(curChr);
+				positions_ = std::move(curPos);
+				end_       = ( ( positions_.front() < positions_.back() ) ? positions_.back() : positions_.front() );
+				chr_       = curChr;
 				fbgn_      = move(curFBgn);
 				delLength_ = 0;
 				continue;
 			}
-			if ( curPos[0] < curPos.back() ) { // current CDS not complemented
-				if (curPos[0] < end_) { // there is overlap
+			if ( curPos.front() < curPos.back() ) { // current CDS not complemented
+				if (curPos.front() < end_) { // there is overlap
 					logFile_ << "Detected overlap between " << fbgn_ << " and " << curFBgn << endl;
-					if ( positions_[0] < positions_.back() ) { // previous CDS not complemented, either
-						size_t prevDelLength = 0;
-						for (auto pRit = positions_.rbegin(); pRit != positions_.rend(); ++pRit) {
-							if ( (*pRit) >= curPos[0] ) {
-								prevDelLength++;
-							} else {
-								break;
-							}
-						}
+					if ( positions_.front() < positions_.back() ) { // previous CDS not complemented, either
+						size_t prevDelLength = positions_.countAtLeast(curPos.front());
 						prevDelLength = prevDelLength + (prevDelLength%3);
-						delLength_ = 0;
-						for (auto &p : curPos) {
-							if (p <= end_) {
-								delLength_++;
-							} else {
-								break;
-							}
-						}
+						delLength_ = curPos.countAtMost(end_);
 						delLength_ = delLength_ + (delLength_%3);
 						if ( (prevDelLength < positions_.size()) && (delLength_ < curPos.size()) ) { // delLength_ can be larger than these because of the rounding to codons
-							positions_.resize(positions_.size() - prevDelLength);
+							positions_.trimBack(prevDelLength);
 							sequence_.resize(sequence_.size() - prevDelLength);
 							getFFsites_();
-							curPos.erase(curPos.begin(), curPos.begin() + delLength_);
-							positions_ = move(curPos);
+							curPos.trimFront(delLength_);
+							positions_ = std::move(curPos);
 							delStart_  = 0;
 							end_       = positions_.back();
-							chr_       = move(curChr);
+							chr_       = curChr;
 							fbgn_      = move(curFBgn);
 							continue;
 						} else if ( prevDelLength >= positions_.size() ) {
@@ -288,55 +325,41 @@ void FFextract::getNextRecord_(){
 							} else {
 								logFile_ << fbgn_ << " deleted by overlapping " << curFBgn << endl;
 								// do not extract FF sites
-								curPos.erase(curPos.begin(), curPos.begin() + delLength_);
-								positions_ = move(curPos);
+								curPos.trimFront(delLength_);
+								positions_ = std::move(curPos);
 								delStart_  = 0;
 								end_       = positions_.back();
-								chr_       = move(curChr);
+								chr_       = curChr;
 								fbgn_      = move(curFBgn);
 								continue;
 							}
 						} else {
 							logFile_ << fbgn_ << " deletes the overlapping " << curFBgn << endl;
 							// extract sites, but do not move the new position info (chromosome and FBgn info is moved)
-							positions_.resize(positions_.size() - prevDelLength);
+							positions_.trimBack(prevDelLength);
 							sequence_.resize(sequence_.size() - prevDelLength);
 							getFFsites_();
 							positions_.clear();
 							delStart_ = 0;
 							end_      = 0;
-							chr_      = move(curChr);
+							chr_      = curChr;
 							fbgn_     = move(curFBgn);
 							continue;
 						}
 					} else { // previous CDS complemented
-						size_t prevDelLength = 0;
-						for (auto &p : positions_) {
-							if (p >= curPos[0]) {
-								prevDelLength++;
-							} else {
-								break;
-							}
-						}
+						size_t prevDelLength = positions_.countAtLeast(curPos.front());
 						prevDelLength = prevDelLength + (prevDelLength%3);
-						delLength_ = 0;
-						for (auto &c : curPos) {
-							if (c <= end_) {
-								delLength_++;
-							} else {
-								break;
-							}
-						}
+						delLength_ = curPos.countAtMost(end_);
 						delLength_ = delLength_ + (delLength_%3);
 						delStart_  = 0;
 						if ( (prevDelLength < positions_.size()) && (delLength_ < curPos.size()) ) { // delLength_ can be larger than these because of the rounding to codons
-							positions_.erase(positions_.begin(), positions_.begin() + prevDelLength);
+							positions_.trimFront(prevDelLength);
 							sequence_.erase(0, prevDelLength);
 							getFFsites_();
-							curPos.erase(curPos.begin(), curPos.begin() + delLength_);
-							positions_ = move(curPos);
+							curPos.trimFront(delLength_);
+							positions_ = std::move(curPos);
 							end_       = positions_.back();
-							chr_       = move(curChr);
+							chr_       = curChr;
 							fbgn_      = move(curFBgn);
 							continue;
 						} else if ( prevDelLength >= positions_.size() ) {
@@ -349,31 +372,31 @@ void FFextract::getNextRecord_(){
 							} else {
 								logFile_ << fbgn_ << " deleted by overlapping " << curFBgn << endl;
 								// do not extract FF sites
-								curPos.erase(curPos.begin(), curPos.begin() + delLength_);
-								positions_ = move(curPos);
+								curPos.trimFront(delLength_);
+								positions_ = std::move(curPos);
 								end_       = positions_.back();
-								chr_       = move(curChr);
+								chr_       = curChr;
 								fbgn_      = move(curFBgn);
 								continue;
 							}
 						} else {
 							logFile_ << fbgn_ << " deletes the overlapping " << curFBgn << endl;
 							// extract sites, but do not move the new position info (chromosome and FBgn info is moved)
-							positions_.erase(positions_.begin(), positions_.begin() + prevDelLength);
+							positions_.trimFront(prevDelLength);
 							sequence_.erase(0, prevDelLength);
 							getFFsites_();
 							positions_.clear();
 							end_  = 0;
-							chr_  = move(curChr);
+							chr_  = curChr;
 							fbgn_ = move(curFBgn);
 							continue;
 						}
 					}
 				} else { // no overlap
 					getFFsites_();
-					positions_ = move(curPos);
+					positions_ = std::move(curPos);
 					end_       = positions_.back();
-					chr_       = move(curChr);
+					chr_       = curChr;
 					fbgn_      = move(curFBgn);
 					delLength_ = 0;
 					continue;
@@ -381,34 +404,20 @@ void FFextract::getNextRecord_(){
 			} else { // current CDS complemented
 				if (curPos.back() < end_) { // there is overlap
 					logFile_ << "Detected overlap between " << fbgn_ << " and complemented " << curFBgn << endl;
-					if ( positions_[0] < positions_.back() ) { // previous CDS not complemented
-						size_t prevDelLength = 0;
-						for (auto pRit = positions_.rbegin(); pRit != positions_.rend(); ++pRit) {
-							if ( (*pRit) >= curPos.back() ) {
-								prevDelLength++;
-							} else {
-								break;
-							}
-						}
+					if ( positions_.front() < positions_.back() ) { // previous CDS not complemented
+						size_t prevDelLength = positions_.countAtLeast(curPos.back());
 						prevDelLength = prevDelLength + (prevDelLength%3);
-						delLength_ = 0;
-						for (auto cRit = curPos.rbegin(); cRit != curPos.rend(); ++cRit) {
-							if ( (*cRit) <= end_ ) {
-								delLength_++;
-							} else {
-								break;
-							}
-						}
+						delLength_ = curPos.countAtMost(end_);
 						delLength_ = delLength_ + (delLength_%3);
 						if ( (prevDelLength < positions_.size()) && (delLength_ < curPos.size()) ) { // delLength_ can be larger than these because of the rounding to codons
-							positions_.resize(positions_.size() - prevDelLength);
+							positions_.trimBack(prevDelLength);
 							sequence_.resize(sequence_.size() - prevDelLength);
 							getFFsites_();
 							delStart_  = curPos.size() - delLength_;
-							curPos.resize(curPos.size() - delLength_);
-							positions_ = move(curPos);
-							end_       = positions_[0];
-							chr_       = move(curChr);
+							curPos.trimBack(delLength_);
+							positions_ = std::move(curPos);
+							end_       = positions_.front();
+							chr_       = curChr;
 							fbgn_      = move(curFBgn);
 							continue;
 						} else if ( prevDelLength >= positions_.size() ) {
@@ -422,55 +431,41 @@ void FFextract::getNextRecord_(){
 							} else {
 								logFile_ << fbgn_ << " deleted by overlapping " << curFBgn << endl;
 								// do not extract FF sites
-								curPos.resize(curPos.size() - delLength_);
 								delStart_  = curPos.size() - delLength_;
-								positions_ = move(curPos);
-								end_       = positions_[0];
-								chr_       = move(curChr);
+								curPos.trimBack(delLength_);
+								positions_ = std::move(curPos);
+								end_       = positions_.front();
+								chr_       = curChr;
 								fbgn_      = move(curFBgn);
 								continue;
 							}
 						} else {
 							logFile_ << fbgn_ << " deletes the overlapping " << curFBgn << endl;
 							// extract sites, but do not move the new position info (chromosome and FBgn info is moved)
-							positions_.resize(positions_.size() - prevDelLength);
+							positions_.trimBack(prevDelLength);
 							sequence_.resize(sequence_.size() - prevDelLength);
 							getFFsites_();
 							positions_.clear();
 							delStart_ = 0;
 							end_      = 0;
-							chr_      = move(curChr);
+							chr_      = curChr;
 							fbgn_     = move(curFBgn);
 							continue;
 						}
 					} else { // previous CDS complemented
-						size_t prevDelLength = 0;
-						for (auto &p : positions_) {
-							if ( p >= curPos.back() ) {
-								prevDelLength++;
-							} else {
-								break;
-							}
-						}
+						size_t prevDelLength = positions_.countAtLeast(curPos.back());
 						prevDelLength = prevDelLength + (prevDelLength%3);
-						delLength_    = 0;
-						for (auto cRit = curPos.rbegin(); cRit != curPos.rend(); ++cRit) {
-							if ( (*cRit) <= end_ ) {
-								delLength_++;
-							} else {
-								break;
-							}
-						}
+						delLength_    = curPos.countAtMost(end_);
 						delLength_ = delLength_ + (delLength_%3);
 						if ( (prevDelLength < positions_.size()) && (delLength_ < curPos.size()) ) { // delLength_ can be larger than these because of the rounding to codons
-							positions_.erase(positions_.begin(), positions_.begin() + prevDelLength);
+							positions_.trimFront(prevDelLength);
 							sequence_.erase(0, prevDelLength);
 							getFFsites_();
 							delStart_  = curPos.size() - delLength_;
-							curPos.resize(curPos.size() - delLength_);
-							positions_ = move(curPos);
-							end_       = positions_[0];
-							chr_       = move(curChr);
+							curPos.trimBack(delLength_);
+							positions_ = std::move(curPos);
+							end_       = positions_.front();
+							chr_       = curChr;
 							fbgn_      = move(curFBgn);
 							continue;
 						} else if ( prevDelLength >= positions_.size() ) {
@@ -484,31 +479,31 @@ void FFextract::getNextRecord_(){
 								logFile_ << fbgn_ << " deleted by overlapping " << curFBgn << endl;
 								// do not extract FF sites
 								delStart_  = curPos.size() - delLength_;
-								curPos.resize(curPos.size() - delLength_);
-								positions_ = move(curPos);
-								end_       = positions_[0];
-								chr_       = move(curChr);
+								curPos.trimBack(delLength_);
+								positions_ = std::move(curPos);
+								end_       = positions_.front();
+								chr_       = curChr;
 								fbgn_      = move(curFBgn);
 								continue;
 							}
 						} else {
 							logFile_ << fbgn_ << " deletes the overlapping " << curFBgn << endl;
 							// extract sites, but do not move the new position info (chromosome and FBgn info is moved)
-							positions_.erase(positions_.begin(), positions_.begin() + prevDelLength);
+							positions_.trimFront(prevDelLength);
 							sequence_.erase(0, prevDelLength);
 							getFFsites_();
 							positions_.clear();
 							end_  = 0;
-							chr_  = move(curChr);
+							chr_  = curChr;
 							fbgn_ = move(curFBgn);
 							continue;
 						}
 					}
 				} else { // no overlap
 					getFFsites_();
-					positions_ = move(curPos);
-					end_       = positions_[0];
-					chr_       = move(curChr);
+					positions_ = std::move(curPos);
+					end_       = positions_.front();
+					chr_       = curChr;
 					fbgn_      = move(curFBgn);
 					delLength_ = 0;
 					continue;
@@ -527,40 +522,35 @@ void FFextract::getNextRecord_(){
 }
 
 void FFextract::getFFsites_(){
-	vector<string> locSites;
-	for (size_t i = 0; i < sequence_.size(); i += 3) {
-		string codon = sequence_.substr(i, 3);
-		if (codon[1] == 'A') { // no codons with A in second position have four-fold sites
-			continue;
-		} else if (codon[1] == 'T') {
-			if ( (codon[0] == 'C') || (codon[0] == 'G') ) {
-				stringstream rSS(ios::out);
-				rSS << chr_ << "\t" << fbgn_ << "\t" << positions_[i+2];
-				locSites.push_back( rSS.str() );
-			}
-		} else if (codon[1] == 'C') { // all codons with C in second position are four-fold
-			stringstream rSS(ios::out);
-			rSS << chr_ << "\t" << fbgn_ << "\t" << positions_[i+2];
-			locSites.push_back( rSS.str() );
-		} else { // G
-			if ( (codon[0] == 'C') || (codon[0] == 'G') ) {
-				stringstream rSS(ios::out);
-				rSS << chr_ << "\t" << fbgn_ << "\t" << positions_[i+2];
-				locSites.push_back( rSS.str() );
+	const size_t firstSite   = ffSites_.size();
+	const size_t firstCoding = codingSites_.size();
+	FFsite site;
+	site.chromosome = chr_;
+	site.gene       = static_cast<uint32_t>( genes_.size() );
+	const char *codon         = sequence_.data();
+	const size_t codingLength = std::min( sequence_.size(), positions_.size() );
+	for (size_t i = 0; i + 2 < codingLength; i += 3) {
+		if (annotate_) {
+			uint8_t fold[3];
+			GeneticCode::degeneracy(codon + i, fold);
+			for (size_t iPos = 0; iPos < 3; iPos++) {
+				if (fold[iPos] != GeneticCode::undetermined) {
+					codingSites_.push_back( CodingSite{positions_.position(i + iPos), site.gene, fold[iPos]} );
+				}
 			}
 		}
-	}
-	if ( locSites.size() ) {
-		if ( positions_[0] < positions_.back() ) {
-			for (auto &l : locSites) {
-				ffSites_.push_back(move(l));
-			}
-		} else {
-			for (auto lRit = locSites.rbegin(); lRit != locSites.rend(); ++lRit) {
-				ffSites_.push_back(move(*lRit));
-			}
+		if ( GeneticCode::fourFold(codon + i) ) {
+			site.position = positions_.position(i + 2);
+			ffSites_.push_back(site);
 		}
 	}
+	if ( (ffSites_.size() == firstSite) && (codingSites_.size() == firstCoding) ) {
+		return;
+	}
+	genes_.push_back(fbgn_);
+	geneChromosomes_.push_back(chr_);
+	if ( positions_.front() >= positions_.back() ) { // complemented CDS: list sites in chromosome order
+		std::reverse(ffSites_.begin() + static_cast<std::ptrdiff_t>(firstSite), ffSites_.end());
+		std::reverse(codingSites_.begin() + static_cast<std::ptrdiff_t>(firstCoding), codingSites_.end());
+	}
 }
-
-
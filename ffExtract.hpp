@@ -23,7 +23,7 @@
  * \copyright Copyright (c) 2019 Anthony J. Greenberg
  * \version 0.1
  *
- * Class definitions and interface documentation for extracting four-fold synonymous site positions from FASTA files.
+ * Class definitions and interface documentation for extracting four-fold synonymous site positions, and degeneracy classes of all coding positions, from FASTA files.
  *
  */
 
@@ -33,25 +33,137 @@
 #include <string>
 #include <vector>
 
+#include "genomeDictionary.hpp"
+#include "geneticCode.hpp"
+
 using std::fstream;
 using std::string;
 using std::vector;
 
 namespace BayesicSpace {
+	/** \brief Four-fold synonymous site
+	 *
+	 * Chromosome and gene names are stored as IDs and looked up with `FFextract::chromosomeName()` and `FFextract::geneName()` when the site is written out.
+	 */
+	struct FFsite {
+		/** \brief Chromosome ID */
+		uint32_t chromosome;
+		/** \brief Gene ID */
+		uint32_t gene;
+		/** \brief Chromosome position */
+		uint64_t position;
+	};
+	/** \brief Coding site with its degeneracy class
+	 *
+	 * The gene name and chromosome are looked up with `FFextract::geneName()` and `FFextract::geneChromosome()` when the site is written out.
+	 */
+	struct CodingSite {
+		/** \brief Chromosome position */
+		uint64_t position;
+		/** \brief Gene ID */
+		uint32_t gene;
+		/** \brief Degeneracy class (0, 2, 3, or 4) */
+		uint8_t fold;
+	};
+
+	/** \brief CDS coordinate map
+	 *
+	 * Maps CDS offsets (positions in the spliced coding sequence, starting at 0) to genome positions.
+	 * A CDS is stored as a list of exon intervals, in CDS order, with prefix sums of their lengths; offsets are mapped by binary search on the prefix sums.
+	 * Exons are assumed not to overlap and to be listed in chromosome order (reversed for complemented CDS), so that genome positions change monotonically along the CDS.
+	 */
+	class ExonMap {
+		public:
+			/** \brief Default constructor */
+			ExonMap() : offsets_{0}, complemented_{false} {};
+
+			/** \brief Remove all exons and set orientation
+			 *
+			 * \param[in] complemented `true` if the CDS is on the complementary strand
+			 */
+			void reset(const bool &complemented) { firstPositions_.clear(); offsets_.assign(1, 0); complemented_ = complemented; };
+			/** \brief Remove all exons */
+			void clear() { reset(false); };
+			/** \brief Append an exon
+			 *
+			 * Exons are added in CDS order. For a complemented CDS the first CDS nucleotide of the exon is at `end`.
+			 *
+			 * \param[in] start exon start position
+			 * \param[in] end exon end position (no smaller than `start`)
+			 */
+			void addExon(const uint64_t &start, const uint64_t &end);
+			/** \brief CDS length
+			 *
+			 * \return number of nucleotides in the CDS
+			 */
+			size_t size() const { return offsets_.back(); };
+			/** \brief Is the CDS empty?
+			 *
+			 * \return `true` if there are no nucleotides
+			 */
+			bool empty() const { return offsets_.back() == 0; };
+			/** \brief Genome position of a CDS nucleotide
+			 *
+			 * \param[in] offset CDS offset (must be smaller than `size()`)
+			 * \return genome position
+			 */
+			uint64_t position(const size_t &offset) const;
+			/** \brief Genome position of the first CDS nucleotide
+			 *
+			 * \return genome position
+			 */
+			uint64_t front() const { return position(0); };
+			/** \brief Genome position of the last CDS nucleotide
+			 *
+			 * \return genome position
+			 */
+			uint64_t back() const { return position(offsets_.back() - 1); };
+			/** \brief Count nucleotides at or after a position
+			 *
+			 * \param[in] position genome position
+			 * \return number of CDS nucleotides with genome positions no smaller than `position`
+			 */
+			size_t countAtLeast(const uint64_t &position) const;
+			/** \brief Count nucleotides at or before a position
+			 *
+			 * \param[in] position genome position
+			 * \return number of CDS nucleotides with genome positions no larger than `position`
+			 */
+			size_t countAtMost(const uint64_t &position) const;
+			/** \brief Remove nucleotides from the start of the CDS
+			 *
+			 * \param[in] length number of nucleotides to remove
+			 */
+			void trimFront(const size_t &length);
+			/** \brief Remove nucleotides from the end of the CDS
+			 *
+			 * \param[in] length number of nucleotides to remove
+			 */
+			void trimBack(const size_t &length);
+		private:
+			/// Genome position of the first CDS nucleotide in each exon
+			vector<uint64_t> firstPositions_;
+			/// CDS offset of the first nucleotide in each exon, followed by the CDS length
+			vector<size_t> offsets_;
+			/// Is the CDS on the complementary strand?
+			bool complemented_;
+	};
+
 	/** \brief Four-fold synonymous site extraction
 	 *
 	 * The class reads a FASTA file with coding sequences and extracts four-fold synonymous sites.
 	 * The algorithm assumes that the records are sorted by chromosome position of the start site. This can be achieved by running the enclosed `fastaSort` program.
 	 * It is also assumed that there are no CDS that completely within other genes. The `fastaSort` program eliminates such cases.
 	 * We also assume that the sequence portions of FASTA records are all on one line. This is how `fastaSort` outputs them.
-	 * The chromosome names are for Drosophila (2L, 2R, 3L, 3R, 4, X). The names may be preceded by the Scf_ prefix, which is used in the D. simulans genome.
-	 * Output chromosome names are the Drosophila set preceded by `chr`.
+	 * Chromosome names are taken from the `loc=` field, up to the colon. The names may be preceded by the Scf_ prefix, which is used in the D. simulans genome and is dropped.
+	 * Each name is added to a chromosome dictionary once, and records are compared by chromosome ID.
+	 * Codons are classified by table look-up (see `GeneticCode`). Degeneracy classes of all coding positions can be collected in the same pass as the four-fold sites.
 	 *
 	 */
 	class FFextract {
 	public:
 		/** \brief Default constructor */
-		FFextract() : header_{""}, sequence_{""}, end_{0}, chr_{""}, fbgn_{""}, delStart_{0}, delLength_{0} { fastaFile_.exceptions(fstream::badbit); logFile_.exceptions(fstream::badbit); };
+		FFextract() : header_{""}, sequence_{""}, end_{0}, chr_{GenomeDictionary::missing}, fbgn_{""}, delStart_{0}, delLength_{0}, annotate_{false} { fastaFile_.exceptions(fstream::badbit); logFile_.exceptions(fstream::badbit); };
 		/** \brief Constructor
 		 *
 		 * \param[in] fastaName name of the FASTA file
@@ -68,14 +180,40 @@ namespace BayesicSpace {
 		 *
 		 * \param[in] in the object to be moved
 		 */
-		FFextract(FFextract &&in) : fastaFile_{move(in.fastaFile_)}, logFile_{move(in.logFile_)}, header_{move(in.header_)}, sequence_{move(in.sequence_)}, positions_{move(in.positions_)}, end_{in.end_}, chr_{move(in.chr_)}, fbgn_{move(in.fbgn_)}, delStart_{in.delStart_}, delLength_{in.delLength_} {};
+		FFextract(FFextract &&in) : fastaFile_{move(in.fastaFile_)}, logFile_{move(in.logFile_)}, header_{move(in.header_)}, sequence_{move(in.sequence_)}, positions_{std::move(in.positions_)}, end_{in.end_}, chr_{in.chr_}, genome_{std::move(in.genome_)}, fbgn_{move(in.fbgn_)}, delStart_{in.delStart_}, delLength_{in.delLength_}, ffSites_{move(in.ffSites_)}, codingSites_{move(in.codingSites_)}, genes_{move(in.genes_)}, geneChromosomes_{move(in.geneChromosomes_)}, annotate_{in.annotate_} {};
 		/** \brief Extract four-fold sites from the current record
 		 *
-		 * The vector of positions contains tab-delimited fields: chromosome, FBgn number, and position. The contents of the vector are replaced.
+		 * The contents of the vector are replaced.
+		 *
+		 * \param[out] positionList vector of four-fold sites
+		 */
+		void extractFFsites(vector<FFsite> &positionList);
+		/** \brief Extract four-fold sites and degeneracy classes
+		 *
+		 * In addition to the four-fold sites, lists every coding position whose degeneracy class can be determined (positions in codons with ambiguous nucleotides may be left out). Sites are in the same order as four-fold sites. Overlapping CDS regions are discarded in the same way for both lists. The contents of the vectors are replaced.
+		 *
+		 * \param[out] ffSiteList vector of four-fold sites
+		 * \param[out] codingSiteList vector of coding sites with their degeneracy classes
+		 */
+		void extractSites(vector<FFsite> &ffSiteList, vector<CodingSite> &codingSiteList);
+		/** \brief Chromosome name
+		 *
+		 * \param[in] chromosome chromosome ID
+		 * \return chromosome name
+		 */
+		const string &chromosomeName(const uint32_t &chromosome) const { return genome_.name(chromosome); };
+		/** \brief Gene name
+		 *
+		 * \param[in] gene gene ID
+		 * \return FBgn number of the gene
+		 */
+		const string &geneName(const uint32_t &gene) const { return genes_[gene]; };
+		/** \brief Gene chromosome
 		 *
-		 * \param[out] positionList vector of four-fold site positions.
+		 * \param[in] gene gene ID
+		 * \return chromosome ID of the gene
 		 */
-		void extractFFsites(vector<string> &positionList);
+		uint32_t geneChromosome(const uint32_t &gene) const { return geneChromosomes_[gene]; };
 	private:
 		/** \brief FASTA file to be parsed */
 		fstream fastaFile_;
@@ -88,18 +226,20 @@ namespace BayesicSpace {
 		string header_;
 		/** \brief Current FASTA sequence */
 		string sequence_;
-		/** \brief Position vector
+		/** \brief Genome positions of the current CDS
 		 *
-		 * The same length as `sequence_`, each element is the genome position of the nucleotide in the sequence.
+		 * The same length as `sequence_`, maps each nucleotide in the sequence to its genome position.
 		 */
-		vector <uint64_t> positions_;
+		ExonMap positions_;
 		/** \brief Last CDS position
 		 *
 		 * Not necessarily contained in `positions_` because of possible truncation.
 		 */
 		uint64_t end_;
-		/** \brief Chromosome */
-		string chr_;
+		/** \brief Chromosome ID */
+		uint32_t chr_;
+		/** \brief Chromosome dictionary */
+		GenomeDictionary genome_;
 		/** \brief FBgn number */
 		string fbgn_;
 		/** \brief Start position of sequence truncation
@@ -113,16 +253,24 @@ namespace BayesicSpace {
 		 */
 		size_t delLength_;
 		/** \brief Vector of four-fold site records */
-		vector<string> ffSites_;
+		vector<FFsite> ffSites_;
+		/** \brief Vector of coding sites with degeneracy classes */
+		vector<CodingSite> codingSites_;
+		/** \brief FBgn numbers of records with extracted sites, indexed by gene ID */
+		vector<string> genes_;
+		/** \brief Chromosome IDs of records with extracted sites, indexed by gene ID */
+		vector<uint32_t> geneChromosomes_;
+		/** \brief Collect degeneracy classes of all coding positions */
+		bool annotate_;
 
 		/** \brief Parse the FASTA header
 		 *
 		 *
-		 * \param[out] positions vector of chromosome positions of the sites in the sequence; any contents are replaced
-		 * \param[out] chr chromosome name
+		 * \param[out] positions chromosome positions of the sites in the sequence; any contents are replaced
+		 * \param[out] chr chromosome ID
 		 * \param[out] fbgn FBgn number
 		 */
-		void parseHeader_(vector<uint64_t> &positions, string &chr, string &fbgn);
+		void parseHeader_(ExonMap &positions, uint32_t &chr, string &fbgn);
 		/** \brief Parse a string to range of numbers
 		 *
 		 * String of a STARTPOS..ENDPOS type is parsed and the start and end position returned. The string must be validated before calling.
@@ -134,7 +282,7 @@ namespace BayesicSpace {
 		void getNextRecord_();
 		/** \brief Identifies four-fold sites in the current record
 		 *
-		 * The results are appended to `ffSites_`.
+		 * The results are appended to `ffSites_`. If `annotate_` is set, all coding positions with their degeneracy classes are also appended to `codingSites_`.
 		 */
 		void getFFsites_();
 	};
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Genetic code tables
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Implementation of codon classification by table lookup.
+ *
+ */
+
+#include <cstdint>
+
+#include "geneticCode.hpp"
+
+using namespace BayesicSpace;
+
+const uint8_t GeneticCode::ambiguous;
+const uint8_t GeneticCode::undetermined;
+constexpr uint64_t GeneticCode::fourFoldCodons_;
+constexpr uint64_t GeneticCode::synonymousCounts_[6];
+
+// T, C, A, G (and t, c, a, g) are 0 to 3; everything else is 4
+const uint8_t GeneticCode::nucleotideCodes_[256] = {
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 2, 4, 1, 4, 4, 4, 3, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 0, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 2, 4, 1, 4, 4, 4, 3, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 0, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4
+};
+
+// IUPAC codes in either case (T = 1, C = 2, A = 4, G = 8; U is the same as T); everything else is 0
+const uint8_t GeneticCode::nucleotideSets_[256] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 4, 11, 2, 13, 0, 0, 8, 7, 0, 0, 9, 0, 6, 15, 0,
+	0, 0, 12, 10, 1, 1, 14, 5, 0, 3, 0, 0, 0, 0, 0, 0,
+	0, 4, 11, 2, 13, 0, 0, 8, 7, 0, 0, 9, 0, 6, 15, 0,
+	0, 0, 12, 10, 1, 1, 14, 5, 0, 3, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+bool GeneticCode::ambiguousFourFold_(const char *codon){
+	const uint8_t firstSet  = nucleotideSets_[ static_cast<unsigned char>(codon[0]) ];
+	const uint8_t secondSet = nucleotideSets_[ static_cast<unsigned char>(codon[1]) ];
+	if ( (firstSet == 0) || (secondSet == 0) ) { // not nucleotides
+		return false;
+	}
+	for (size_t first = 0; first < 4; first++) {
+		if ( ( (firstSet >> first) & 1 ) == 0 ) {
+			continue;
+		}
+		for (size_t second = 0; second < 4; second++) {
+			if ( ( (secondSet >> second) & 1 ) && ( ( (fourFoldCodons_ >> (16*first + 4*second)) & 1 ) == 0 ) ) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void GeneticCode::ambiguousDegeneracy_(const char *codon, uint8_t *fold){
+	const uint8_t sets[3] = { nucleotideSets_[ static_cast<unsigned char>(codon[0]) ], nucleotideSets_[ static_cast<unsigned char>(codon[1]) ], nucleotideSets_[ static_cast<unsigned char>(codon[2]) ] };
+	fold[0] = undetermined;
+	fold[1] = undetermined;
+	fold[2] = undetermined;
+	if ( (sets[0] == 0) || (sets[1] == 0) || (sets[2] == 0) ) { // not nucleotides
+		return;
+	}
+	bool first = true;
+	bool agree[3] = {true, true, true};
+	for (size_t n0 = 0; n0 < 4; n0++) {
+		if ( ( (sets[0] >> n0) & 1 ) == 0 ) {
+			continue;
+		}
+		for (size_t n1 = 0; n1 < 4; n1++) {
+			if ( ( (sets[1] >> n1) & 1 ) == 0 ) {
+				continue;
+			}
+			for (size_t n2 = 0; n2 < 4; n2++) {
+				if ( ( (sets[2] >> n2) & 1 ) == 0 ) {
+					continue;
+				}
+				const size_t index = 16*n0 + 4*n1 + n2;
+				for (size_t iPos = 0; iPos < 3; iPos++) {
+					const uint8_t curFold = foldClass_(index, iPos);
+					if (first) {
+						fold[iPos] = curFold;
+					} else if (curFold != fold[iPos]) {
+						agree[iPos] = false;
+					}
+				}
+				first = false;
+			}
+		}
+	}
+	for (size_t iPos = 0; iPos < 3; iPos++) {
+		if (!agree[iPos]) {
+			fold[iPos] = undetermined;
+		}
+	}
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Genetic code tables
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Class definition for codon classification by table lookup.
+ *
+ */
+
+#ifndef geneticCode_hpp
+#define geneticCode_hpp
+
+#include <cstdint>
+#include <cstddef>
+
+namespace BayesicSpace {
+	/** \brief Standard genetic code
+	 *
+	 * Amino acids (one-letter codes, `*` for stop) encoded by the 64 codons, in TCAG order of the first, second, and third nucleotide.
+	 */
+	constexpr char standardCode[] = "FFLLSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG";
+
+	/** \brief Number of synonymous nucleotides at a codon position
+	 *
+	 * Counts the nucleotides (including the one in the codon) that, placed at the given position, leave the encoded amino acid (or stop) unchanged.
+	 *
+	 * \param[in] codon codon index (16 times the first, 4 times the second, plus the third nucleotide code, in TCAG order)
+	 * \param[in] position codon position (0, 1, or 2)
+	 * \return number of synonymous nucleotides, from 1 to 4
+	 */
+	constexpr size_t synonymousCount(const size_t codon, const size_t position) {
+		return static_cast<size_t>(standardCode[ ( codon & ~(static_cast<size_t>(3) << 2*(2 - position)) ) ] == standardCode[codon])
+			+ static_cast<size_t>(standardCode[ ( codon & ~(static_cast<size_t>(3) << 2*(2 - position)) ) | (static_cast<size_t>(1) << 2*(2 - position)) ] == standardCode[codon])
+			+ static_cast<size_t>(standardCode[ ( codon & ~(static_cast<size_t>(3) << 2*(2 - position)) ) | (static_cast<size_t>(2) << 2*(2 - position)) ] == standardCode[codon])
+			+ static_cast<size_t>(standardCode[ ( codon | (static_cast<size_t>(3) << 2*(2 - position)) ) ] == standardCode[codon]);
+	}
+	/** \brief Is the third position of a codon four-fold degenerate?
+	 *
+	 * \param[in] codon codon index (16 times the first, 4 times the second, plus the third nucleotide code, in TCAG order)
+	 * \return `true` if the four codons that differ only at the third position encode the same amino acid
+	 */
+	constexpr bool thirdFourFold(const size_t codon) {
+		return synonymousCount(codon, 2) == 4;
+	}
+	/** \brief Four-fold codon mask
+	 *
+	 * \param[in] codon first codon index to include
+	 * \return bit mask with a bit set for each codon, starting at `codon`, whose third position is four-fold degenerate
+	 */
+	constexpr uint64_t fourFoldMask(const size_t codon) {
+		return ( codon == 64 ? 0 : ( (thirdFourFold(codon) ? static_cast<uint64_t>(1) << codon : 0) | fourFoldMask(codon + 1) ) );
+	}
+	/** \brief Packed synonymous counts
+	 *
+	 * \param[in] position codon position (0, 1, or 2)
+	 * \param[in] codon first codon index to include
+	 * \param[in] last one past the last codon index to include (no more than 32 codons in total)
+	 * \return synonymous counts minus one, two bits per codon, starting at the lowest bits
+	 */
+	constexpr uint64_t synonymousCountWord(const size_t position, const size_t codon, const size_t last) {
+		return ( codon == last ? 0 : ( static_cast<uint64_t>(synonymousCount(codon, position) - 1) << 2*(codon % 32) ) | synonymousCountWord(position, codon + 1, last) );
+	}
+
+	/** \brief Codon classification
+	 *
+	 * Classifies codons by table lookup. Nucleotides are mapped to 2-bit codes in TCAG order (T = 0, C = 1, A = 2, G = 3, either case), and a codon's index is 16 times the first, 4 times the second, plus the third code.
+	 * The four-fold degeneracy of all 64 codons is computed from the genetic code at compile time and stored in one 64-bit word.
+	 * Degeneracy classes (0-, 2-, 3-, or 4-fold) of all three positions of every codon are also tabulated at compile time, two bits per codon position.
+	 * Codons with ambiguous nucleotides (IUPAC codes such as N or R) are classified by checking every codon they can stand for.
+	 */
+	class GeneticCode {
+		public:
+			/// Code of a nucleotide that is not A, C, G, or T
+			static const uint8_t ambiguous = 4;
+			/// Degeneracy class of a codon position that cannot be determined
+			static const uint8_t undetermined = 255;
+			/** \brief Nucleotide code
+			 *
+			 * \param[in] nucleotide nucleotide character
+			 * \return 2-bit code in TCAG order; `ambiguous` for any character other than A, C, G, or T (in either case)
+			 */
+			static uint8_t nucleotideCode(const char &nucleotide) { return nucleotideCodes_[ static_cast<unsigned char>(nucleotide) ]; };
+			/** \brief Is the third codon position four-fold degenerate?
+			 *
+			 * A codon with ambiguous first or second nucleotides is four-fold only if every codon it can stand for is. The third nucleotide does not matter.
+			 *
+			 * \param[in] codon pointer to the first of the three codon nucleotides
+			 * \return `true` if the third position is four-fold degenerate
+			 */
+			static bool fourFold(const char *codon){
+				const uint8_t first  = nucleotideCode(codon[0]);
+				const uint8_t second = nucleotideCode(codon[1]);
+				if ( (first | second) & ambiguous ) {
+					return ambiguousFourFold_(codon);
+				}
+				return (fourFoldCodons_ >> (16*first + 4*second)) & 1;
+			};
+			/** \brief Degeneracy classes of the three codon positions
+			 *
+			 * A position is _n_-fold degenerate if _n_ of the four nucleotides at that position encode the same amino acid (stop codons count as one amino acid); positions where only the codon's own nucleotide does are 0-fold.
+			 * A codon with ambiguous nucleotides gets a class at a position only if all codons it can stand for agree; otherwise the class is `undetermined`.
+			 *
+			 * \param[in] codon pointer to the first of the three codon nucleotides
+			 * \param[out] fold array of three degeneracy classes (0, 2, 3, 4, or `undetermined`), one per codon position
+			 */
+			static void degeneracy(const char *codon, uint8_t *fold){
+				const uint8_t first  = nucleotideCode(codon[0]);
+				const uint8_t second = nucleotideCode(codon[1]);
+				const uint8_t third  = nucleotideCode(codon[2]);
+				if ( (first | second | third) & ambiguous ) {
+					ambiguousDegeneracy_(codon, fold);
+					return;
+				}
+				const size_t index = 16*first + 4*second + third;
+				fold[0] = foldClass_(index, 0);
+				fold[1] = foldClass_(index, 1);
+				fold[2] = foldClass_(index, 2);
+			};
+		private:
+			/// Four-fold codons, one bit per codon index
+			static constexpr uint64_t fourFoldCodons_ = fourFoldMask(0);
+			/// Synonymous counts minus one, two bits per codon; two words (codons 0 to 31 and 32 to 63) per codon position
+			static constexpr uint64_t synonymousCounts_[6] = {
+				synonymousCountWord(0, 0, 32), synonymousCountWord(0, 32, 64),
+				synonymousCountWord(1, 0, 32), synonymousCountWord(1, 32, 64),
+				synonymousCountWord(2, 0, 32), synonymousCountWord(2, 32, 64)
+			};
+			/** \brief Degeneracy class of a codon position
+			 *
+			 * \param[in] codon codon index
+			 * \param[in] position codon position (0, 1, or 2)
+			 * \return degeneracy class (0, 2, 3, or 4)
+			 */
+			static uint8_t foldClass_(const size_t &codon, const size_t &position){
+				const uint8_t count = static_cast<uint8_t>( ( synonymousCounts_[2*position + codon/32] >> 2*(codon % 32) ) & 3 ) + 1;
+				return (count == 1 ? 0 : count);
+			};
+			/// Nucleotide codes indexed by character
+			static const uint8_t nucleotideCodes_[256];
+			/// Sets of nucleotides (one bit per code) that each character can stand for, indexed by character; 0 for characters that are not nucleotides
+			static const uint8_t nucleotideSets_[256];
+			/** \brief Four-fold degeneracy of a codon with ambiguous nucleotides
+			 *
+			 * \param[in] codon pointer to the first of the three codon nucleotides
+			 * \return `true` if the third position is four-fold degenerate for every resolution of the first two nucleotides
+			 */
+			static bool ambiguousFourFold_(const char *codon);
+			/** \brief Degeneracy classes of a codon with ambiguous nucleotides
+			 *
+			 * \param[in] codon pointer to the first of the three codon nucleotides
+			 * \param[out] fold array of three degeneracy classes, `undetermined` where the codons the ambiguous codon can stand for disagree
+			 */
+			static void ambiguousDegeneracy_(const char *codon, uint8_t *fold);
+	};
+}
+#endif /* geneticCode_hpp */
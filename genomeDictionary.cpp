@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Chromosome name dictionary
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Class implementation for interning chromosome names as small integer IDs.
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "genomeDictionary.hpp"
+
+using std::string;
+using std::vector;
+using std::unordered_map;
+
+using namespace BayesicSpace;
+
+const uint32_t GenomeDictionary::missing;
+
+string GenomeDictionary::canonicalName(const char *name, const size_t &length){
+	string canonical;
+	if (length <= 2) {
+		canonical.reserve(length + 3);
+		canonical.assign("chr");
+	}
+	canonical.append(name, length);
+	return canonical;
+}
+
+uint32_t GenomeDictionary::intern(const string &name){
+	auto nameIt = ids_.find(name);
+	if ( nameIt == ids_.end() ) {
+		if (names_.size() >= missing) {
+			throw string("ERROR: too many chromosome names");
+		}
+		nameIt = ids_.emplace( name, static_cast<uint32_t>( names_.size() ) ).first;
+		names_.push_back(name);
+	}
+	return nameIt->second;
+}
+
+uint32_t GenomeDictionary::find(const string &name) const {
+	auto nameIt = ids_.find(name);
+	if ( nameIt == ids_.end() ) {
+		return missing;
+	}
+	return nameIt->second;
+}
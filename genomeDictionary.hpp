@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Chromosome name dictionary
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Class definition and interface documentation for interning chromosome names as small integer IDs.
+ *
+ */
+
+#ifndef genomeDictionary_hpp
+#define genomeDictionary_hpp
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+using std::string;
+using std::vector;
+using std::unordered_map;
+
+namespace BayesicSpace {
+	/** \brief Chromosome name dictionary
+	 *
+	 * Maps chromosome names to consecutive integer IDs, assigned in the order the names are first added.
+	 * Names are looked up once, when files and queries are loaded; everything downstream (cursors, queries, per-chromosome counts) refers to chromosomes by ID.
+	 * Names are stored as given. Names from different sources are made comparable with `canonicalName()`.
+	 */
+	class GenomeDictionary {
+		public:
+			/** \brief Default constructor */
+			GenomeDictionary(){};
+
+			/// ID returned for names that are not in the dictionary
+			static const uint32_t missing = 0xFFFFFFFF;
+			/** \brief Canonical chromosome name
+			 *
+			 * Names of one or two characters (e.g., "X" or "2L") get a "chr" prefix, so that chromosome names with and without it match.
+			 *
+			 * \param[in] name start of the name
+			 * \param[in] length name length
+			 * \return canonical name
+			 */
+			static string canonicalName(const char *name, const size_t &length);
+			/** \brief Canonical chromosome name
+			 *
+			 * \param[in] name chromosome name
+			 * \return canonical name
+			 */
+			static string canonicalName(const string &name) { return canonicalName( name.data(), name.size() ); };
+			/** \brief Add a name
+			 *
+			 * \param[in] name chromosome name
+			 * \return ID of the name, new if the name was not in the dictionary
+			 */
+			uint32_t intern(const string &name);
+			/** \brief Look up a name
+			 *
+			 * \param[in] name chromosome name
+			 * \return ID of the name; `missing` if it is not in the dictionary
+			 */
+			uint32_t find(const string &name) const;
+			/** \brief Chromosome name
+			 *
+			 * \param[in] chromosome chromosome ID
+			 * \return chromosome name
+			 */
+			const string &name(const uint32_t &chromosome) const { return names_[chromosome]; };
+			/** \brief Chromosome names
+			 *
+			 * \return chromosome names, indexed by ID
+			 */
+			const vector<string> &names() const { return names_; };
+			/** \brief Number of chromosomes
+			 *
+			 * \return number of names in the dictionary
+			 */
+			size_t size() const { return names_.size(); };
+			/** \brief Remove all names */
+			void clear() { names_.clear(); ids_.clear(); };
+		private:
+			/// Names, indexed by ID
+			vector<string> names_;
+			/// IDs, indexed by name
+			unordered_map<string, uint32_t> ids_;
+	};
+}
+
+#endif /* genomeDictionary_hpp */
@@ -23,13 +23,14 @@
  * \copyright Copyright (c) 2019 Anthony J. Greenberg
  * \version 0.1
  *
- * Takes a FASTA file with coding sequences (CDS), sorted by chromosome and position by `fastaSort`, and outputs a list of four-fold synonymous sites. Regions that are covered by overlapping CDS are discarded.
+ * Takes a FASTA file with coding sequences (CDS), sorted by chromosome and position by `fastaSort`, and outputs a list of four-fold synonymous sites. Optionally, it also lists every coding position with its degeneracy class (0-, 2-, 3-, or 4-fold), extracted in the same pass. Regions that are covered by overlapping CDS are discarded.
  *
  * The flags are:
  *
  * -i input file name
  * -l log file name
- * -o output file name
+ * -o four-fold site output file name
+ * -a degeneracy class output file name (optional if -o is given)
  *
  */
 
@@ -41,6 +42,7 @@
 
 #include "utilities.hpp"
 #include "ffExtract.hpp"
+#include "tsvWriter.hpp"
 
 using std::vector;
 using std::unordered_map;
@@ -57,23 +59,49 @@ int main(int argc, char *argv[]){
 	if ( clInfo['i'].empty() ) {
 		cerr << "Must specify a FASTA input file with flag -i" << endl;
 		exit(1);
-	} else if ( clInfo['o'].empty() ) {
-		cerr << "Must specify output file name with flag -o" << endl;
+	} else if ( clInfo['o'].empty() && clInfo['a'].empty() ) {
+		cerr << "Must specify output file name with flag -o and/or -a" << endl;
 		exit(2);
 	} else if ( clInfo['l'].empty() ) {
 		cerr << "Must specify the log file name with flag -l" << endl;
 	}
 	try {
 		FFextract fasta(clInfo['i'], clInfo['l']);
-		vector<string> out;
-		fasta.extractFFsites(out);
-		fstream oFS;
-		oFS.open(clInfo['o'].c_str(), ios::out|ios::trunc);
-		oFS << "chr\tFBgn\tpos" << endl;
-		for (auto &r : out) {
-			oFS << r << endl;
+		vector<FFsite> out;
+		vector<CodingSite> annotated;
+		if ( clInfo['a'].empty() ) {
+			fasta.extractFFsites(out);
+		} else {
+			fasta.extractSites(out, annotated);
+		}
+		if ( !clInfo['o'].empty() ) {
+			TSVwriter oFS(clInfo['o']);
+			oFS.putText("chr\tFBgn\tpos\n");
+			for (auto &s : out) {
+				oFS.putText( fasta.chromosomeName(s.chromosome) );
+				oFS.tab();
+				oFS.putText( fasta.geneName(s.gene) );
+				oFS.tab();
+				oFS.putUnsigned(s.position);
+				oFS.newLine();
+			}
+			oFS.close();
+		}
+		if ( !clInfo['a'].empty() ) {
+			TSVwriter aFS(clInfo['a']);
+			aFS.putText("chr\tFBgn\tpos\tfold\n");
+			for (auto &s : annotated) {
+				aFS.putText( fasta.chromosomeName( fasta.geneChromosome(s.gene) ) );
+				aFS.tab();
+				aFS.putText( fasta.geneName(s.gene) );
+				aFS.tab();
+				aFS.putUnsigned(s.position);
+				aFS.tab();
+				aFS.putUnsigned(s.fold);
+				aFS.newLine();
+			}
+			aFS.close();
 		}
-		oFS.close();
 
 	} catch(string error) {
 		cerr << error << endl;
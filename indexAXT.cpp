@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Index an .axt alignment file
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Builds the block index of an .axt file and saves it next to the alignment (the .axt file name with `.axti` appended), where `divSites` and `polySites` pick it up.
+ * Without the index these programs have to scan the whole alignment before answering the first query.
+ * Also saves the outgroup state of every primary genome position (the .axt file name with `.anc` appended), which `polySites` uses instead of the alignment,
+ * and a bit-packed copy of the alignment sequences (the .axt file name with `.axtp` appended), which `divSites` reads instead of the .axt text.
+ * Alignments with characters that cannot be packed (e.g., IUPAC ambiguity codes other than N) get no packed copy; a warning is printed and the other files are still written.
+ * If writing any of the files fails, all of them are removed, so a failed run leaves no partial set behind.
+ * The flags are:
+ *
+ * -a .axt file name
+ * -t number of threads used to build the outgroup state table (optional, default 1)
+ *
+ */
+
+#include <string>
+#include <unordered_map>
+#include <iostream>
+#include <cstdio>
+
+#include "parseAXT.hpp"
+#include "utilities.hpp"
+
+using std::unordered_map;
+using std::cerr;
+using std::endl;
+
+using namespace BayesicSpace;
+
+int main(int argc, char *argv[]){
+	try {
+		unordered_map<char, string> clInfo;
+		parseCL(argc, argv, clInfo);
+		if ( clInfo['a'].empty() ) {
+			throw string("Must specify .axt file with flag -a");
+		}
+
+		size_t nThreads = 1;
+		if ( !clInfo['t'].empty() ) {
+			nThreads = strtoul(clInfo['t'].c_str(), NULL, 0);
+			if (nThreads == 0) {
+				throw string("Number of threads (flag -t) must be a positive integer");
+			}
+		}
+
+		ParseAXT axt(clInfo['a']);
+		const string indexFileName  = clInfo['a'] + ".axti";
+		const string stateFileName  = clInfo['a'] + ".anc";
+		const string packedFileName = clInfo['a'] + ".axtp";
+
+		// pack first, so that an alignment that cannot be packed is found before anything is written
+		bool packed = true;
+		try {
+			axt.packAlignment();
+		} catch(string error) {
+			cerr << "WARNING: no packed copy of the alignment is saved (" << error << ")" << endl;
+			packed = false;
+		}
+
+		// a failed run removes whatever it wrote, so there is never a partial set of files next to the alignment
+		try {
+			axt.saveIndex(indexFileName);
+			axt.saveOutgroupStates(stateFileName, nThreads);
+			if (packed) {
+				axt.savePackedAlignment(packedFileName);
+			}
+		} catch(...) {
+			remove( indexFileName.c_str() );
+			remove( stateFileName.c_str() );
+			remove( packedFileName.c_str() );
+			throw;
+		}
+		if (!packed) {
+			remove( packedFileName.c_str() ); // a packed copy of an earlier version of the alignment would be stale anyway
+		}
+		exit(0);
+	} catch(string error) {
+		cerr << error << endl;
+		exit(1);
+	}
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Memory-mapped files
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Class implementation for read-only memory-mapped files.
+ *
+ */
+
+#include <string>
+#include <cstring>
+#include <cerrno>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "mappedFile.hpp"
+
+using std::string;
+
+using namespace BayesicSpace;
+
+MappedFile::MappedFile(const string &fileName) : data_{nullptr}, size_{0}, modified_{0} {
+	int fd = open(fileName.c_str(), O_RDONLY);
+	if (fd == -1) {
+		string message = "ERROR: cannot open file " + fileName + " to read: " + strerror(errno);
+		throw message;
+	}
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) == -1) {
+		string message = "ERROR: cannot get the size of file " + fileName + ": " + strerror(errno);
+		close(fd);
+		throw message;
+	}
+	size_     = static_cast<size_t>(fileStat.st_size);
+	modified_ = static_cast<uint64_t>(fileStat.st_mtim.tv_sec)*1000000000ULL + static_cast<uint64_t>(fileStat.st_mtim.tv_nsec);
+	if (size_ == 0) { // zero-length mappings are not allowed; an empty file has no contents to view
+		close(fd);
+		return;
+	}
+	void *mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // the mapping keeps its own reference to the file
+	if (mapping == MAP_FAILED) {
+		size_ = 0;
+		string message = "ERROR: cannot map file " + fileName + " to memory: " + strerror(errno);
+		throw message;
+	}
+	data_ = static_cast<const char*>(mapping);
+}
+
+MappedFile::~MappedFile(){
+	unmap_();
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&in){
+	if (&in != this) {
+		unmap_();
+		data_        = in.data_;
+		size_        = in.size_;
+		modified_    = in.modified_;
+		in.data_     = nullptr;
+		in.size_     = 0;
+		in.modified_ = 0;
+	}
+	return *this;
+}
+
+void MappedFile::unmap_(){
+	if (data_ != nullptr) {
+		munmap( const_cast<char*>(data_), size_ );
+		data_ = nullptr;
+		size_ = 0;
+	}
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Memory-mapped files
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Class definitions and interface documentation for read-only memory-mapped files.
+ *
+ */
+
+#ifndef mappedFile_hpp
+#define mappedFile_hpp
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+using std::string;
+
+namespace BayesicSpace {
+	/** \brief Read-only memory-mapped file
+	 *
+	 * Maps the whole file into memory so that parsers can work with views into the file contents instead of copying lines.
+	 * The mapping is released when the object is destroyed. Pointers into the mapping stay valid when the object is moved.
+	 *
+	 */
+	class MappedFile {
+		public:
+			/** \brief Default constructor */
+			MappedFile() : data_{nullptr}, size_{0}, modified_{0} {};
+			/** \brief File name constructor
+			 *
+			 * Maps the file read-only.
+			 *
+			 * \param[in] fileName file name
+			 */
+			MappedFile(const string &fileName);
+
+			/** \brief Destructor */
+			~MappedFile();
+			/// Copy constructor
+			MappedFile(const MappedFile &in) = delete;
+			/// Move constructor
+			MappedFile(MappedFile &&in) : data_{in.data_}, size_{in.size_}, modified_{in.modified_} { in.data_ = nullptr; in.size_ = 0; in.modified_ = 0; };
+			/// Copy assignment
+			MappedFile &operator=(const MappedFile &in) = delete;
+			/// Move assignment
+			MappedFile &operator=(MappedFile &&in);
+
+			/** \brief File contents
+			 *
+			 * \return pointer to the first byte of the file (`nullptr` if the file is empty or not mapped)
+			 */
+			const char *data() const { return data_; };
+			/** \brief File size
+			 *
+			 * \return number of bytes in the file
+			 */
+			size_t size() const { return size_; };
+			/** \brief File modification time
+			 *
+			 * Taken when the file is mapped. Used, together with the size, to tell whether files derived from this one are stale.
+			 *
+			 * \return modification time in nanoseconds since the epoch
+			 */
+			uint64_t modified() const { return modified_; };
+		private:
+			/// Start of the mapping
+			const char *data_;
+			/// Mapping size
+			size_t size_;
+			/// Modification time (nanoseconds since the epoch)
+			uint64_t modified_;
+			/// Release the mapping
+			void unmap_();
+	};
+}
+
+#endif /* mappedFile_hpp */
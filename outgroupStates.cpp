@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Genome-wide outgroup states
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Class implementation for looking up outgroup states in a precomputed per-position table.
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cctype>
+#include <cstdint>
+
+#include "outgroupStates.hpp"
+#include "mappedFile.hpp"
+#include "genomeDictionary.hpp"
+#include "utilities.hpp"
+
+using std::string;
+using std::vector;
+
+using namespace BayesicSpace;
+
+OutgroupStates::OutgroupStates(const string &fileName) : stateFile_{fileName}, axtSize_{0}, axtModified_{0} {
+	const char *curChar = stateFile_.data();
+	const char *fileEnd = curChar + stateFile_.size();
+	const char *lineEnd = static_cast<const char*>( memchr( curChar, '\n', stateFile_.size() ) );
+	if ( (lineEnd == nullptr) || (strncmp(curChar, "#AXTANC\t", 8) != 0) ) {
+		throw string("ERROR: ") + fileName + " is not an outgroup state file";
+	}
+	uint64_t nChromosomes = 0;
+	curChar = parseUnsigned(curChar + 8, lineEnd, axtSize_);
+	if (curChar == lineEnd) {
+		throw string("ERROR: malformed header in the outgroup state file ") + fileName;
+	}
+	curChar = parseUnsigned(curChar + 1, lineEnd, nChromosomes);
+	if (curChar != lineEnd) {
+		parseUnsigned(curChar + 1, lineEnd, axtModified_);
+	}
+	curChar = lineEnd + 1;
+	for (uint64_t iChr = 0; iChr < nChromosomes; iChr++) {
+		lineEnd = static_cast<const char*>( memchr( curChar, '\n', static_cast<size_t>(fileEnd - curChar) ) );
+		const char *tab = ( lineEnd == nullptr ? nullptr : static_cast<const char*>( memchr( curChar, '\t', static_cast<size_t>(lineEnd - curChar) ) ) );
+		if (tab == nullptr) {
+			throw string("ERROR: malformed header in the outgroup state file ") + fileName;
+		}
+		if ( genome_.intern( string(curChar, tab) ) != iChr ) {
+			throw string("ERROR: repeated chromosome name in the outgroup state file ") + fileName;
+		}
+		uint64_t length = 0;
+		parseUnsigned(tab + 1, lineEnd, length);
+		lengths_.push_back(length);
+		curChar = lineEnd + 1;
+	}
+	for (auto &length : lengths_) {
+		if ( length > static_cast<uint64_t>(fileEnd - curChar) ) {
+			throw string("ERROR: the outgroup state file ") + fileName + " is truncated";
+		}
+		states_.push_back( reinterpret_cast<const uint8_t*>(curChar) );
+		curChar += length;
+	}
+}
+
+OutgroupStates &OutgroupStates::operator=(OutgroupStates &&in){
+	if (&in != this) {
+		stateFile_ = std::move(in.stateFile_);
+		axtSize_     = in.axtSize_;
+		axtModified_ = in.axtModified_;
+		genome_      = std::move(in.genome_);
+		states_      = std::move(in.states_);
+		lengths_     = std::move(in.lengths_);
+	}
+	return *this;
+}
+
+uint8_t OutgroupStates::encode(const char &aligned, const uint16_t &sameChromosome){
+	uint8_t state = 0;
+	switch ( toupper(aligned) ) {
+		case '-':
+		case 'N':
+			break;
+		case 'A':
+			state = 1;
+			break;
+		case 'C':
+			state = 2;
+			break;
+		case 'G':
+			state = 3;
+			break;
+		case 'T':
+			state = 4;
+			break;
+		default:
+			state = 5;
+			break;
+	}
+	if ( (state != 0) && isupper(aligned) ) {
+		state |= 0x08;
+	}
+	if (sameChromosome) {
+		state |= 0x10;
+	}
+	return state;
+}
+
+char OutgroupStates::nucleotide(const uint8_t &state){
+	const char *upper = "NACGT?";
+	const char *lower = "Nacgt?";
+	const uint8_t base = state & 0x07;
+	if (base > 5) {
+		return '?';
+	}
+	return ( quality(state) ? upper[base] : lower[base] );
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Genome-wide outgroup states
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Class definition for looking up outgroup states in a precomputed per-position table.
+ *
+ */
+
+#ifndef outgroupStates_hpp
+#define outgroupStates_hpp
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+#include "mappedFile.hpp"
+#include "genomeDictionary.hpp"
+
+using std::string;
+using std::vector;
+
+namespace BayesicSpace {
+	/** \brief Outgroup state table
+	 *
+	 * The outgroup (aligned) state of every primary genome position, one byte per position, as projected from an .axt alignment by `ParseAXT::saveOutgroupStates()`.
+	 * The file starts with a text header: `#AXTANC`, the size of the .axt file in bytes, the number of chromosomes and the .axt file modification time in nanoseconds, tab-delimited on the first line,
+	 * followed by one line per chromosome with its name and length (the last position covered by the alignment). The state bytes of each chromosome follow in the same order.
+	 * The .axt size and modification time are used to detect stale tables; tables saved without the modification time read it as 0, so they are always stale.
+	 * The file is memory-mapped, so a lookup is a single array access.
+	 *
+	 * Each byte holds the outgroup nucleotide (bits 0--2: 0 for positions that are not covered or align to a gap or `N`, 1--4 for A, C, G, T, and 5 for any other character),
+	 * whether the outgroup nucleotide is upper case (bit 3), and whether it is on the same chromosome (bit 4). Bytes with nucleotide 0 carry no outgroup information.
+	 */
+	class OutgroupStates {
+		public:
+			/** \brief Default constructor */
+			OutgroupStates() : axtSize_{0}, axtModified_{0} {};
+			/** \brief Constructor
+			 *
+			 * \param[in] fileName name of the outgroup state file
+			 */
+			OutgroupStates(const string &fileName);
+
+			/** \brief Destructor */
+			~OutgroupStates(){};
+			/// Copy constructor
+			OutgroupStates(const OutgroupStates &in) = delete;
+			/// Move constructor
+			OutgroupStates(OutgroupStates &&in) : stateFile_{std::move(in.stateFile_)}, axtSize_{in.axtSize_}, axtModified_{in.axtModified_}, genome_{std::move(in.genome_)}, states_{std::move(in.states_)}, lengths_{std::move(in.lengths_)} {};
+			/// Copy assignment
+			OutgroupStates &operator=(const OutgroupStates &in) = delete;
+			/// Move assignment
+			OutgroupStates &operator=(OutgroupStates &&in);
+
+			/** \brief Encode an outgroup state
+			 *
+			 * \param[in] aligned aligned (outgroup) nucleotide, `-` if the position is not covered
+			 * \param[in] sameChromosome is the aligned nucleotide on the same chromosome (1) or not (0)?
+			 * \return state byte
+			 */
+			static uint8_t encode(const char &aligned, const uint16_t &sameChromosome);
+			/** \brief Outgroup nucleotide
+			 *
+			 * \param[in] state state byte
+			 * \return the nucleotide, lower case if it is not upper case in the alignment; `N` if there is none, `?` for other characters
+			 */
+			static char nucleotide(const uint8_t &state);
+			/** \brief Outgroup base quality
+			 *
+			 * \param[in] state state byte
+			 * \return 1 if the nucleotide is upper case (high quality), 0 otherwise
+			 */
+			static uint16_t quality(const uint8_t &state) { return (state >> 3) & 1; };
+			/** \brief Outgroup chromosome
+			 *
+			 * \param[in] state state byte
+			 * \return 1 if the outgroup nucleotide is on the same chromosome, 0 otherwise
+			 */
+			static uint16_t sameChromosome(const uint8_t &state) { return (state >> 4) & 1; };
+
+			/** \brief Is a table loaded?
+			 *
+			 * \return true if the object was loaded from a file
+			 */
+			bool loaded() const { return !states_.empty(); };
+			/** \brief Size of the source .axt file
+			 *
+			 * \return size in bytes of the .axt file the table was built from
+			 */
+			uint64_t axtSize() const { return axtSize_; };
+			/** \brief Modification time of the source .axt file
+			 *
+			 * \return modification time (nanoseconds since the epoch) of the .axt file the table was built from
+			 */
+			uint64_t axtModified() const { return axtModified_; };
+			/** \brief Chromosome dictionary
+			 *
+			 * The chromosomes are in the same order as in the source .axt file, so the IDs are the same as the `ParseAXT` IDs.
+			 *
+			 * \return the dictionary
+			 */
+			const GenomeDictionary &genome() const { return genome_; };
+			/** \brief Outgroup state of a position
+			 *
+			 * \param[in] chromosome chromosome ID
+			 * \param[in] position primary genome position
+			 * \return state byte; 0 if the position is outside the table
+			 */
+			uint8_t state(const uint32_t &chromosome, const uint64_t &position) const {
+				return ( ( chromosome < states_.size() ) && (position > 0) && (position <= lengths_[chromosome]) ) ? states_[chromosome][position - 1] : 0;
+			};
+		private:
+			/// The memory-mapped state file
+			MappedFile stateFile_;
+			/// Size of the source .axt file
+			uint64_t axtSize_;
+			/// Modification time of the source .axt file
+			uint64_t axtModified_;
+			/// Chromosome names
+			GenomeDictionary genome_;
+			/// Start of each chromosome's states, indexed by chromosome ID
+			vector<const uint8_t*> states_;
+			/// Chromosome lengths, indexed by chromosome ID
+			vector<uint64_t> lengths_;
+	};
+}
+
+#endif /* outgroupStates_hpp */
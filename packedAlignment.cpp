@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Packed alignment store
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Class implementation for a bit-packed copy of .axt alignment sequences.
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <utility>
+#include <system_error>
+
+#include "packedAlignment.hpp"
+#include "mappedFile.hpp"
+#include "utilities.hpp"
+
+using std::string;
+using std::vector;
+using std::fstream;
+using std::stringstream;
+using std::ios;
+using std::system_error;
+
+using namespace BayesicSpace;
+
+PackedAlignment::PackedAlignment(const string &fileName) : fileName_{fileName}, packedFile_{fileName}, planes_{nullptr}, nWords_{0}, axtSize_{0}, axtModified_{0} {
+	const char *fileStart = packedFile_.data();
+	const char *fileEnd   = fileStart + packedFile_.size();
+	const char *lineEnd   = static_cast<const char*>( memchr( fileStart, '\n', packedFile_.size() ) );
+	if ( (lineEnd == nullptr) || (strncmp(fileStart, "#AXTP\t", 6) != 0) ) {
+		throw string("ERROR: ") + fileName + " is not a packed alignment file";
+	}
+	uint64_t nRecords = 0;
+	const char *curChar = parseUnsigned(fileStart + 6, lineEnd, axtSize_);
+	curChar = parseUnsigned( ( curChar == lineEnd ? curChar : curChar + 1 ), lineEnd, nRecords );
+	curChar = parseUnsigned( ( curChar == lineEnd ? curChar : curChar + 1 ), lineEnd, nWords_ );
+	parseUnsigned( ( curChar == lineEnd ? curChar : curChar + 1 ), lineEnd, axtModified_ );
+	curChar = lineEnd + 1;
+	records_.reserve(nRecords);
+	for (uint64_t iRec = 0; iRec < nRecords; iRec++) {
+		lineEnd = ( curChar < fileEnd ? static_cast<const char*>( memchr( curChar, '\n', static_cast<size_t>(fileEnd - curChar) ) ) : nullptr );
+		if (lineEnd == nullptr) {
+			throw string("ERROR: truncated record list in the packed alignment file ") + fileName;
+		}
+		PackedRecord record;
+		uint64_t same = 0;
+		curChar = parseUnsigned(curChar, lineEnd, record.offset);
+		curChar = parseUnsigned( ( curChar == lineEnd ? curChar : curChar + 1 ), lineEnd, record.nColumns );
+		curChar = parseUnsigned( ( curChar == lineEnd ? curChar : curChar + 1 ), lineEnd, record.firstWord );
+		curChar = parseUnsigned( ( curChar == lineEnd ? curChar : curChar + 1 ), lineEnd, same );
+		record.sameChr = static_cast<uint16_t>(same);
+		if ( (curChar != lineEnd) || ( record.firstWord + (record.nColumns + 63)/64 > nWords_ ) || ( !records_.empty() && (record.offset <= records_.back().offset) ) ) {
+			throw string("ERROR: malformed record line in the packed alignment file ") + fileName;
+		}
+		records_.push_back(record);
+		curChar = lineEnd + 1;
+	}
+	// the words start at the first multiple of eight bytes after the header
+	const size_t wordStart = ( static_cast<size_t>(curChar - fileStart) + 7 ) & ~static_cast<size_t>(7);
+	if ( packedFile_.size() != wordStart + nPlanes*nWords_*sizeof(uint64_t) ) {
+		throw string("ERROR: the packed alignment file ") + fileName + " is the wrong size";
+	}
+	planes_ = reinterpret_cast<const uint64_t*>(fileStart + wordStart);
+}
+
+PackedAlignment::PackedAlignment(const PackedAlignment &in) : fileName_{in.fileName_}, words_{in.words_}, planes_{nullptr}, nWords_{in.nWords_}, axtSize_{in.axtSize_}, axtModified_{in.axtModified_}, records_{in.records_} {
+	if ( fileName_.empty() ) {
+		planes_ = words_.data();
+	} else {
+		packedFile_ = MappedFile(fileName_);
+		planes_     = reinterpret_cast<const uint64_t*>( packedFile_.data() + ( reinterpret_cast<const char*>(in.planes_) - in.packedFile_.data() ) );
+	}
+}
+
+PackedAlignment::PackedAlignment(PackedAlignment &&in) : fileName_{std::move(in.fileName_)}, packedFile_{std::move(in.packedFile_)}, words_{std::move(in.words_)}, planes_{in.planes_}, nWords_{in.nWords_}, axtSize_{in.axtSize_}, axtModified_{in.axtModified_}, records_{std::move(in.records_)} {
+	in.planes_ = nullptr;
+	in.nWords_ = 0;
+}
+
+PackedAlignment &PackedAlignment::operator=(PackedAlignment &&in){
+	if (&in != this) {
+		fileName_    = std::move(in.fileName_);
+		packedFile_  = std::move(in.packedFile_);
+		words_       = std::move(in.words_);
+		planes_      = in.planes_;
+		nWords_      = in.nWords_;
+		axtSize_     = in.axtSize_;
+		axtModified_ = in.axtModified_;
+		records_     = std::move(in.records_);
+		in.planes_   = nullptr;
+		in.nWords_   = 0;
+	}
+	return *this;
+}
+
+void PackedAlignment::addRecord(const uint64_t &offset, const char *primary, const char *aligned, const size_t &nColumns, const uint16_t &sameChr){
+	if ( !fileName_.empty() ) {
+		throw string("ERROR: cannot add records to a packed alignment loaded from a file");
+	}
+	if ( !records_.empty() && (offset <= records_.back().offset) ) {
+		throw string("ERROR: packed alignment records must be added in order of increasing offset");
+	}
+	PackedRecord record;
+	record.offset    = offset;
+	record.nColumns  = nColumns;
+	record.firstWord = nWords_;
+	record.sameChr   = sameChr;
+	const uint64_t recWords = (nColumns + 63)/64;
+	words_.resize(nPlanes*(nWords_ + recWords), 0);
+	const char *sequences[] = {primary, aligned};
+	const size_t lowPlanes[] = {primaryLow, alignedLow};
+	for (size_t iSeq = 0; iSeq < 2; iSeq++) {
+		for (size_t iCol = 0; iCol < nColumns; iCol++) {
+			uint64_t *word     = words_.data() + nPlanes*(nWords_ + iCol/64) + lowPlanes[iSeq];
+			const uint64_t bit = static_cast<uint64_t>(1) << (iCol % 64);
+			switch (sequences[iSeq][iCol]) {
+				case '-':
+					word[primaryGap - primaryLow] |= bit;
+					break;
+				case 'n':
+					word[primaryLower - primaryLow] |= bit;
+					word[primaryUnknown - primaryLow] |= bit;
+					break;
+				case 'N':
+					word[primaryUnknown - primaryLow] |= bit;
+					break;
+				case 'a':
+					word[primaryLower - primaryLow] |= bit;
+					break;
+				case 'A':
+					break;
+				case 'c':
+					word[primaryLower - primaryLow] |= bit;
+					word[0] |= bit;
+					break;
+				case 'C':
+					word[0] |= bit;
+					break;
+				case 'g':
+					word[primaryLower - primaryLow] |= bit;
+					word[primaryHigh - primaryLow] |= bit;
+					break;
+				case 'G':
+					word[primaryHigh - primaryLow] |= bit;
+					break;
+				case 't':
+					word[primaryLower - primaryLow] |= bit;
+					word[0] |= bit;
+					word[primaryHigh - primaryLow] |= bit;
+					break;
+				case 'T':
+					word[0] |= bit;
+					word[primaryHigh - primaryLow] |= bit;
+					break;
+				default:
+					string wrongThing = "ERROR: cannot pack alignment character '";
+					wrongThing += sequences[iSeq][iCol];
+					wrongThing += "'";
+					throw wrongThing;
+			}
+		}
+	}
+	nWords_ += recWords;
+	planes_  = words_.data();
+	records_.push_back(record);
+}
+
+void PackedAlignment::save(const string &fileName, const uint64_t &axtSize, const uint64_t &axtModified) const {
+	stringstream header;
+	header << "#AXTP\t" << axtSize << "\t" << records_.size() << "\t" << nWords_ << "\t" << axtModified << "\n";
+	for (auto &r : records_) {
+		header << r.offset << "\t" << r.nColumns << "\t" << r.firstWord << "\t" << r.sameChr << "\n";
+	}
+	string headerText = header.str();
+	headerText.append( ( 8 - headerText.size() % 8 ) % 8, '\n' ); // pad to a word boundary
+	// the planes may be mapped from fileName itself, so write a new file and rename it
+	const string tmpName = fileName + ".tmp";
+	fstream packedFile;
+	try {
+		packedFile.exceptions(fstream::badbit | fstream::failbit);
+		packedFile.open(tmpName.c_str(), ios::out | ios::trunc | ios::binary);
+		packedFile.write( headerText.data(), static_cast<std::streamsize>( headerText.size() ) );
+		packedFile.write( reinterpret_cast<const char*>(planes_), static_cast<std::streamsize>(nPlanes*nWords_*sizeof(uint64_t)) );
+		packedFile.close();
+	} catch(system_error &error) {
+		string message = "ERROR: cannot write the packed alignment file " + fileName + ": " + error.code().message();
+		throw message;
+	}
+	if (std::rename( tmpName.c_str(), fileName.c_str() ) != 0) {
+		string message = "ERROR: cannot write the packed alignment file " + fileName;
+		throw message;
+	}
+}
+
+const PackedRecord *PackedAlignment::find(const uint64_t &offset) const {
+	auto recIt = std::lower_bound(records_.begin(), records_.end(), offset, [](const PackedRecord &record, const uint64_t &value){ return record.offset < value; });
+	if ( ( recIt == records_.end() ) || (recIt->offset != offset) ) {
+		return nullptr;
+	}
+	return &(*recIt);
+}
+
+uint64_t PackedAlignment::word_(const size_t &iPlane, const uint64_t &bit) const {
+	const uint64_t iWord = bit/64;
+	const unsigned shift = static_cast<unsigned>(bit % 64);
+	if (iWord >= nWords_) {
+		return 0;
+	}
+	uint64_t bits = planes_[nPlanes*iWord + iPlane] >> shift;
+	if ( shift && (iWord + 1 < nWords_) ) {
+		bits |= planes_[nPlanes*(iWord + 1) + iPlane] << (64 - shift);
+	}
+	return bits;
+}
+
+void PackedAlignment::plane(const PackedRecord &record, const Plane &iPlane, const size_t &firstCol, const size_t &nColumns, uint64_t *bits) const {
+	const size_t nWords   = (nColumns + 63)/64;
+	const uint64_t first  = 64*record.firstWord + firstCol;
+	for (size_t iWord = 0; iWord < nWords; iWord++) {
+		bits[iWord] = word_(iPlane, first + 64*iWord);
+	}
+	if (nColumns % 64) {
+		bits[nWords - 1] &= (static_cast<uint64_t>(1) << (nColumns % 64)) - 1;
+	}
+}
+
+void PackedAlignment::masks(const PackedRecord &record, const size_t &firstCol, const size_t &nColumns, uint64_t *primaryGap, uint64_t *alignedGap, uint64_t *unknown, uint64_t *match, uint64_t *upper) const {
+	const size_t nWords  = (nColumns + 63)/64;
+	const uint64_t first = 64*record.firstWord + firstCol;
+	for (size_t iWord = 0; iWord < nWords; iWord++) {
+		const uint64_t bit     = first + 64*iWord;
+		const uint64_t inRange = ( ( (iWord + 1 < nWords) || (nColumns % 64 == 0) ) ? ~static_cast<uint64_t>(0) : (static_cast<uint64_t>(1) << (nColumns % 64)) - 1 );
+		primaryGap[iWord] = inRange & word_(PackedAlignment::primaryGap, bit);
+		alignedGap[iWord] = inRange & word_(PackedAlignment::alignedGap, bit);
+		unknown[iWord]    = inRange & ( word_(primaryUnknown, bit) | word_(alignedUnknown, bit) );
+		match[iWord]      = inRange & ~( ( word_(primaryLow, bit) ^ word_(alignedLow, bit) ) | ( word_(primaryHigh, bit) ^ word_(alignedHigh, bit) ) );
+		upper[iWord]      = inRange & ~( word_(primaryLower, bit) | word_(alignedLower, bit) );
+	}
+}
+
+char PackedAlignment::character_(const PackedRecord &record, const size_t &iCol, const size_t &lowPlane) const {
+	const uint64_t iWord = record.firstWord + iCol/64;
+	const unsigned shift = static_cast<unsigned>(iCol % 64);
+	const uint64_t *word = planes_ + nPlanes*iWord + lowPlane;
+	if ( (word[primaryGap - primaryLow] >> shift) & 1 ) {
+		return '-';
+	}
+	const bool lower = (word[primaryLower - primaryLow] >> shift) & 1;
+	if ( (word[primaryUnknown - primaryLow] >> shift) & 1 ) {
+		return (lower ? 'n' : 'N');
+	}
+	const size_t code = ( (word[0] >> shift) & 1 ) | ( ( (word[primaryHigh - primaryLow] >> shift) & 1 ) << 1 );
+	return (lower ? "acgt"[code] : "ACGT"[code]);
+}
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Packed alignment store
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Class definition for a bit-packed copy of .axt alignment sequences.
+ *
+ */
+
+#ifndef packedAlignment_hpp
+#define packedAlignment_hpp
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "mappedFile.hpp"
+
+using std::string;
+using std::vector;
+
+namespace BayesicSpace {
+	/** \brief Location of a packed record
+	 *
+	 * Identifies a record by the offset of its header in the .axt file and locates its columns in the bitplanes.
+	 */
+	struct PackedRecord {
+		/// Byte offset of the record header in the .axt file
+		uint64_t offset;
+		/// Number of alignment columns
+		uint64_t nColumns;
+		/// First bitplane word of the record (each record starts on a word boundary)
+		uint64_t firstWord;
+		/// Is the aligned chromosome the same (1 for yes, 0 for no)?
+		uint16_t sameChr;
+	};
+
+	/** \brief Bit-packed alignment sequences
+	 *
+	 * Stores the two sequences of each .axt record in ten bitplanes, one bit per alignment column in each: the 2-bit nucleotide code (A = 0, C = 1, G = 2, T = 3) as a low and a high plane,
+	 * and separate gap (`-`), unknown (`n` or `N`) and lower case planes, for each of the two species. The planes of each 64-column word are stored together, so a range of columns is read from consecutive memory.
+	 * Column comparisons are done on whole words; the original characters can be recovered one at a time.
+	 *
+	 * The store is built in memory one record at a time, and can be saved to and memory-mapped from a file.
+	 * The file starts with a text header: `#AXTP`, the size of the .axt file in bytes, the number of records, the number of words per plane and the .axt file modification time in nanoseconds, tab-delimited,
+	 * followed by one line per record with the `PackedRecord` fields. The bitplane words follow, in native byte order, starting at the first multiple of eight bytes after the header.
+	 * The .axt size and modification time are used to detect stale files; files saved without the modification time read it as 0, so they are always stale.
+	 */
+	class PackedAlignment {
+		public:
+			/// Bitplane indexes
+			enum Plane : size_t {
+				primaryLow = 0, primaryHigh, primaryGap, primaryUnknown, primaryLower,
+				alignedLow, alignedHigh, alignedGap, alignedUnknown, alignedLower,
+				nPlanes
+			};
+			/** \brief Default constructor */
+			PackedAlignment() : planes_{nullptr}, nWords_{0}, axtSize_{0}, axtModified_{0} {};
+			/** \brief Constructor
+			 *
+			 * Maps a saved store.
+			 *
+			 * \param[in] fileName name of the file written by `save()`
+			 */
+			PackedAlignment(const string &fileName);
+
+			/** \brief Destructor */
+			~PackedAlignment(){};
+			/** \brief Copy constructor
+			 *
+			 * A store loaded from a file is mapped again.
+			 *
+			 * \param[in] in object to copy
+			 */
+			PackedAlignment(const PackedAlignment &in);
+			/// Move constructor
+			PackedAlignment(PackedAlignment &&in);
+			/// Copy assignment
+			PackedAlignment &operator=(const PackedAlignment &in) = delete;
+			/// Move assignment
+			PackedAlignment &operator=(PackedAlignment &&in);
+
+			/** \brief Add a record
+			 *
+			 * Records must be added in order of increasing offset. Only `-`, `n`, `N` and the four nucleotides (upper or lower case) can be packed.
+			 *
+			 * \param[in] offset byte offset of the record header in the .axt file
+			 * \param[in] primary primary sequence
+			 * \param[in] aligned aligned sequence
+			 * \param[in] nColumns number of alignment columns
+			 * \param[in] sameChr is the aligned chromosome the same (1) or not (0)?
+			 */
+			void addRecord(const uint64_t &offset, const char *primary, const char *aligned, const size_t &nColumns, const uint16_t &sameChr);
+			/** \brief Save the store
+			 *
+			 * \param[in] fileName output file name
+			 * \param[in] axtSize size of the .axt file in bytes
+			 * \param[in] axtModified modification time of the .axt file (nanoseconds since the epoch)
+			 */
+			void save(const string &fileName, const uint64_t &axtSize, const uint64_t &axtModified) const;
+			/** \brief Is the store empty?
+			 *
+			 * \return true if there are no records
+			 */
+			bool empty() const { return records_.empty(); };
+			/** \brief Number of records
+			 *
+			 * \return number of records
+			 */
+			size_t size() const { return records_.size(); };
+			/** \brief Size of the source .axt file
+			 *
+			 * \return size in bytes recorded in a saved store; 0 for a store built in memory
+			 */
+			uint64_t axtSize() const { return axtSize_; };
+			/** \brief Modification time of the source .axt file
+			 *
+			 * \return modification time (nanoseconds since the epoch) recorded in a saved store; 0 for a store built in memory
+			 */
+			uint64_t axtModified() const { return axtModified_; };
+			/** \brief Find a record
+			 *
+			 * \param[in] offset byte offset of the record header in the .axt file
+			 * \return pointer to the record; `nullptr` if there is no record at this offset
+			 */
+			const PackedRecord *find(const uint64_t &offset) const;
+			/** \brief Extract a bitplane
+			 *
+			 * Bit `i % 64` of word `i / 64` corresponds to column `firstCol + i`; bits past the last column are zero.
+			 *
+			 * \param[in] record the record
+			 * \param[in] iPlane plane index
+			 * \param[in] firstCol first alignment column
+			 * \param[in] nColumns number of columns
+			 * \param[out] bits plane bits; must hold at least `(nColumns + 63)/64` words
+			 */
+			void plane(const PackedRecord &record, const Plane &iPlane, const size_t &firstCol, const size_t &nColumns, uint64_t *bits) const;
+			/** \brief Classify aligned sequence columns
+			 *
+			 * The word-level counterpart of `alignmentMasks()`, with the same mask layout.
+			 * The `match` and `upper` masks are only meaningful for columns that have a nucleotide (not a gap or unknown) in both sequences.
+			 *
+			 * \param[in] record the record
+			 * \param[in] firstCol first alignment column
+			 * \param[in] nColumns number of columns
+			 * \param[out] primaryGap primary sequence gap mask
+			 * \param[out] alignedGap aligned sequence gap mask
+			 * \param[out] unknown unknown nucleotide mask
+			 * \param[out] match nucleotide match mask
+			 * \param[out] upper both upper case mask
+			 */
+			void masks(const PackedRecord &record, const size_t &firstCol, const size_t &nColumns, uint64_t *primaryGap, uint64_t *alignedGap, uint64_t *unknown, uint64_t *match, uint64_t *upper) const;
+			/** \brief Primary sequence character
+			 *
+			 * \param[in] record the record
+			 * \param[in] iCol alignment column
+			 * \return the character as it is in the .axt file
+			 */
+			char primary(const PackedRecord &record, const size_t &iCol) const { return character_(record, iCol, primaryLow); };
+			/** \brief Aligned sequence character
+			 *
+			 * \param[in] record the record
+			 * \param[in] iCol alignment column
+			 * \return the character as it is in the .axt file
+			 */
+			char aligned(const PackedRecord &record, const size_t &iCol) const { return character_(record, iCol, alignedLow); };
+		private:
+			/// Name of the file the store was loaded from (empty if built in memory)
+			string fileName_;
+			/// The memory-mapped store file
+			MappedFile packedFile_;
+			/// Bitplane words of a store built in memory
+			vector<uint64_t> words_;
+			/// Start of the bitplane words, in memory or in the mapped file
+			const uint64_t *planes_;
+			/// Number of words in each plane
+			uint64_t nWords_;
+			/// Size of the source .axt file
+			uint64_t axtSize_;
+			/// Modification time of the source .axt file
+			uint64_t axtModified_;
+			/// Records, in order of offset
+			vector<PackedRecord> records_;
+
+			/** \brief Read 64 bits of a plane
+			 *
+			 * \param[in] iPlane plane index
+			 * \param[in] bit index of the first bit in the plane
+			 * \return 64 plane bits starting at `bit`; bits past the end of the plane are zero
+			 */
+			uint64_t word_(const size_t &iPlane, const uint64_t &bit) const;
+			/** \brief Recover a character
+			 *
+			 * \param[in] record the record
+			 * \param[in] iCol alignment column
+			 * \param[in] lowPlane the low nucleotide plane of the species (`primaryLow` or `alignedLow`)
+			 * \return the character
+			 */
+			char character_(const PackedRecord &record, const size_t &iCol, const size_t &lowPlane) const;
+	};
+}
+
+#endif /* packedAlignment_hpp */
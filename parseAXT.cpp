@@ -29,52 +29,105 @@
 
 #include <string>
 #include <vector>
-#include <unordered_map>
 #include <fstream>
 #include <sstream>
-#include <cstdlib>
+#include <cstring>
 #include <cctype>
+#include <algorithm>
+#include <functional>
+#include <utility>
 #include <system_error>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <limits>
+#include <memory>
 
 #include "parseAXT.hpp"
+#include "mappedFile.hpp"
+#include "simdKernels.hpp"
+#include "utilities.hpp"
 
 using std::fstream;
-using std::ofstream;
 using std::stringstream;
 using std::string;
 using std::vector;
-using std::unordered_map;
-using std::system_error;
+using std::upper_bound;
+using std::pair;
 using std::ios;
+using std::system_error;
+using std::thread;
+using std::mutex;
+using std::lock_guard;
+using std::atomic;
+using std::shared_ptr;
 
 using namespace BayesicSpace;
 
-ParseAXT::ParseAXT(const string &fileName) : sameChr_{0}, primaryStart_{0}, primaryEnd_{0}, alignedStart_{0}, alignedEnd_{0}, chrID_{""}, primarySeq_{""}, alignSeq_{""}, foundChr_{""} {
-	if( axtFile_.is_open() ){
-		axtFile_.close();
-	}
+const uint64_t ParseAXT::sweepPiece_;
 
-	try {
-		axtFile_.open(fileName.c_str(), ios::in);
-	} catch(system_error &error) {
-		string message = "ERROR: cannot open file " + fileName + " to read: " + error.code().message();
-		throw message;
+ParseAXT::ParseAXT(const string &fileName) : fileName_{fileName}, axtFile_{fileName}, blocks_{std::make_shared< const vector< vector<AXTblock> > >()}, packed_{std::make_shared<const PackedAlignment>()}, nextByte_{0}, recordOffset_{0}, sameChr_{0}, primaryStart_{0}, primaryEnd_{0}, alignedStart_{0}, alignedEnd_{0}, chrID_{""}, primarySeq_{nullptr}, alignSeq_{nullptr}, seqLength_{0}, packedRecord_{nullptr}, sequencesLoaded_{false} {
+	bool indexLoaded = false;
+	const string indexFileName = fileName + ".axti";
+	fstream indexTest(indexFileName.c_str(), ios::in);
+	if ( indexTest.is_open() ) {
+		indexTest.close();
+		indexLoaded = loadIndex_(indexFileName);
 	}
-
-	getNextRecord_();
+	if (!indexLoaded) { // no index file, or the index is stale
+		buildIndex_();
+	}
+	if ( blocks_->empty() ) {
+		throw string("No alignment records in file ") + fileName;
+	}
+	const string packedFileName = fileName + ".axtp";
+	fstream packedTest(packedFileName.c_str(), ios::in);
+	if ( packedTest.is_open() ) {
+		packedTest.close();
+		shared_ptr<const PackedAlignment> packed = std::make_shared<const PackedAlignment>(packedFileName);
+		size_t nBlocks = 0;
+		for (auto &chrBlocks : *blocks_) {
+			nBlocks += chrBlocks.size();
+		}
+		if ( ( packed->axtSize() == static_cast<uint64_t>( axtFile_.size() ) ) && ( packed->axtModified() == axtFile_.modified() ) && (packed->size() == nBlocks) ) { // otherwise the .axt file changed after the packed copy was saved
+			packed_ = packed;
+		}
+	}
+	loadRecord_( (*blocks_)[0][0] );
 }
+ParseAXT::ParseAXT(const ParseAXT &in) : fileName_{in.fileName_}, genome_{in.genome_}, blocks_{in.blocks_}, packed_{in.packed_}, callableSites_{in.callableSites_}, divergedSites_{in.divergedSites_}, nextByte_{0}, recordOffset_{0}, sameChr_{0}, primaryStart_{0}, primaryEnd_{0}, alignedStart_{0}, alignedEnd_{0}, chrID_{""}, primarySeq_{nullptr}, alignSeq_{nullptr}, seqLength_{0}, packedRecord_{nullptr}, sequencesLoaded_{false} {
+	if ( fileName_.empty() ) { // nothing to copy from a default-constructed object
+		return;
+	}
+	axtFile_ = MappedFile(fileName_);
+	loadRecord_( (*blocks_)[0][0] );
+}
+
 ParseAXT &ParseAXT::operator=(ParseAXT &&in){
 	if(&in != this){
-		axtFile_      = move(in.axtFile_);
+		fileName_     = move(in.fileName_);
+		axtFile_      = std::move(in.axtFile_);
+		genome_       = std::move(in.genome_);
+		blocks_       = move(in.blocks_);
+		packed_       = std::move(in.packed_);
+		callableSites_ = move(in.callableSites_);
+		divergedSites_ = move(in.divergedSites_);
+		nextByte_     = in.nextByte_;
+		recordOffset_ = in.recordOffset_;
 		sameChr_      = in.sameChr_;
 		primaryStart_ = in.primaryStart_;
 		primaryEnd_   = in.primaryEnd_;
 		alignedStart_ = in.alignedStart_;
 		alignedEnd_   = in.alignedEnd_;
 		chrID_        = move(in.chrID_);
-		primarySeq_   = move(in.primarySeq_);
-		alignSeq_     = move(in.alignSeq_);
-		foundChr_     = move(in.foundChr_);
+		primarySeq_   = in.primarySeq_;
+		alignSeq_     = in.alignSeq_;
+		seqLength_    = in.seqLength_;
+		packedRecord_ = in.packedRecord_;
+		sequencesLoaded_ = in.sequencesLoaded_;
+		runPositions_ = move(in.runPositions_);
+		runColumns_   = move(in.runColumns_);
+		masks_        = move(in.masks_);
 
 	}
 
@@ -98,7 +151,31 @@ string ParseAXT::getMetaData(){
 	return outLine.str();
 }
 
-void ParseAXT::getDivergedSites(const string &chromName, const uint64_t &start, const uint64_t &end, vector<string> &sites, uint64_t &length){
+string ParseAXT::getPrimarySeq(){
+	loadSequences_();
+	if (packedRecord_ == nullptr) {
+		return string(primarySeq_, seqLength_);
+	}
+	string sequence(seqLength_, '-');
+	for (size_t iCol = 0; iCol < seqLength_; iCol++) {
+		sequence[iCol] = primaryNucleotide_(iCol);
+	}
+	return sequence;
+}
+
+string ParseAXT::getAlignedSeq(){
+	loadSequences_();
+	if (packedRecord_ == nullptr) {
+		return string(alignSeq_, seqLength_);
+	}
+	string sequence(seqLength_, '-');
+	for (size_t iCol = 0; iCol < seqLength_; iCol++) {
+		sequence[iCol] = alignedNucleotide_(iCol);
+	}
+	return sequence;
+}
+
+void ParseAXT::getDivergedSites(const uint32_t &chromosome, const uint64_t &start, const uint64_t &end, vector<DivergedSite> &sites, uint64_t &length){
 	if (start >= end) {
 		stringstream wrongThing;
 		wrongThing << "ERROR: start position (";
@@ -112,116 +189,344 @@ void ParseAXT::getDivergedSites(const string &chromName, const uint64_t &start,
 	if ( sites.size() ){
 		sites.clear();
 	}
-	for (uint64_t iSite = start; iSite <= end; iSite++) {
-		// if the current chromosome has already been explored to the end, no need to bother looking
-		if (chromName == foundChr_) {
-			return;
-		}
-		char primary;
-		char aligned;
-		uint16_t same;
-		getSiteStates_(chromName, iSite, primary, aligned, same);  // will search .axt records
-		if ( (primary == '-') || (aligned == '-') ) {  // gaps present; ignore
-			continue;
-		}
-		if ( (primary == 'n') || (aligned == 'n') ) {  // unkown nucleotide present; ignore
-			continue;
-		}
-		if ( (primary == 'N') || (aligned == 'N') ) {  // unkown nucleotide present; ignore
-			continue;
-		}
-		if (primary == aligned) {
-			length++;
-		} else if ( toupper(primary) == toupper(aligned) ) {  // sometimes there are lower-case bases (low-quality I think)
-			length++;
-		} else {  // the sites are divergent
-			stringstream siteInfo;
-			siteInfo << chromName << "\t";
-			siteInfo << iSite << "\t";
-			siteInfo << primary << "\t" << aligned << "\t";
-			siteInfo << same << "\t";
-			if ( isupper(primary) && isupper(aligned) ) {
-				siteInfo << "1";
-			} else {
-				siteInfo << "0";
+	scanRange_(chromosome, start, end, sites, length);
+}
+
+void ParseAXT::getDivergedSites(const vector<uint32_t> &chromosomes, const vector<uint64_t> &positions, DivergedSiteSink &sites, vector<uint64_t> &lengths){
+	if ( positions.size() != chromosomes.size() ) {
+		stringstream wrongThing;
+		wrongThing << "ERROR: the vector of chromosome IDs (size = ";
+		wrongThing << chromosomes.size();
+		wrongThing << ") not the same size as the vector of positions (size = ";
+		wrongThing << positions.size();
+		wrongThing << ") in getDivergedSites()";
+		throw wrongThing.str();
+	}
+	lengths.assign(genome_.size(), 0);
+	DivergedSite site;
+	bool diverged;
+	for (uint64_t iPos = 0; iPos < positions.size(); iPos++) {
+		if ( checkSite_(chromosomes[iPos], positions[iPos], site, diverged) ) {
+			lengths[ chromosomes[iPos] ]++; // the site is covered, so the chromosome is in the dictionary
+			if (diverged) {
+				sites.put(site);
 			}
-			sites.push_back( siteInfo.str() );
-			length++;
 		}
 	}
 }
 
-void ParseAXT::getDivergedSites(const vector<string> &chromNames, const vector<uint64_t> &positions, vector<string> &sites, unordered_map<string, uint64_t> &lengths){
-	if (positions.size() != chromNames.size()) {
+void ParseAXT::getDivergedSites(const vector<uint32_t> &chromosomes, const vector<uint64_t> &positions, DivergedSiteSink &sites, vector<uint64_t> &lengths, const size_t &nThreads){
+	if ( positions.size() != chromosomes.size() ) {
 		stringstream wrongThing;
-		wrongThing << "ERROR: the vector of chromosome names (size = ";
-		wrongThing << chromNames.size();
+		wrongThing << "ERROR: the vector of chromosome IDs (size = ";
+		wrongThing << chromosomes.size();
 		wrongThing << ") not the same size as the vector of positions (size = ";
 		wrongThing << positions.size();
 		wrongThing << ") in getDivergedSites()";
 		throw wrongThing.str();
 	}
-	for (uint64_t iPos = 0; iPos < positions.size(); iPos++) {
-		// if the current chromosome has already been explored to the end, skip (don't return b/c other chromosomes still may be on the list)
-		if (chromNames[iPos] == foundChr_) {
-			continue;
+	vector<AXTchunk> chunks;
+	makeChunks_(chromosomes, nThreads, chunks);
+	vector<size_t> chunkOf( positions.size(), chunks.size() );
+	vector< vector<size_t> > chunkQueries( chunks.size() );
+	for (size_t iPos = 0; iPos < positions.size(); iPos++) {
+		chunkOf[iPos] = findChunk_(chunks, chromosomes[iPos], positions[iPos]);
+		if ( chunkOf[iPos] < chunks.size() ) {
+			chunkQueries[ chunkOf[iPos] ].push_back(iPos);
 		}
-		char primary;
-		char aligned;
-		uint16_t same;
-		getSiteStates_(chromNames[iPos], positions[iPos], primary, aligned, same); // will search the .axt records
-		if ( (primary == '-') || (aligned == '-') ) {  // gaps present; ignore
-			continue;
+	}
+	vector<uint64_t> chunkLengths(chunks.size(), 0);
+	vector< vector< pair<size_t, DivergedSite> > > found( chunks.size() ); // divergent sites of each chunk with their query indexes
+	runTasks_(chunks.size(), nThreads, [&](ParseAXT &reader, const size_t &iChunk){
+		// visit the positions in genome order, so that each record is loaded once; only this task uses the chunk's elements
+		vector<size_t> &queries = chunkQueries[iChunk];
+		std::stable_sort(queries.begin(), queries.end(), [&](const size_t &first, const size_t &second){ return positions[first] < positions[second]; });
+		DivergedSite site;
+		bool diverged;
+		for (auto &iPos : queries) {
+			if ( reader.checkSite_(chromosomes[iPos], positions[iPos], site, diverged) ) {
+				chunkLengths[iChunk]++;
+				if (diverged) {
+					found[iChunk].push_back( pair<size_t, DivergedSite>(iPos, site) );
+				}
+			}
 		}
-		if ( (primary == 'n') || (aligned == 'n') ) {  // unkown nucleotide present; ignore
-			continue;
+		std::sort(found[iChunk].begin(), found[iChunk].end(), [](const pair<size_t, DivergedSite> &first, const pair<size_t, DivergedSite> &second){ return first.first < second.first; });
+	});
+	lengths.assign(genome_.size(), 0);
+	for (size_t iChunk = 0; iChunk < chunks.size(); iChunk++) {
+		lengths[chunks[iChunk].chromosome] += chunkLengths[iChunk];
+	}
+	// pass the sites on in query order
+	vector<size_t> nextSite(chunks.size(), 0);
+	for (size_t iPos = 0; iPos < positions.size(); iPos++) {
+		const size_t iChunk = chunkOf[iPos];
+		if ( ( iChunk < chunks.size() ) && ( nextSite[iChunk] < found[iChunk].size() ) && (found[iChunk][ nextSite[iChunk] ].first == iPos) ) {
+			sites.put(found[iChunk][ nextSite[iChunk] ].second);
+			nextSite[iChunk]++;
+		}
+	}
+}
+
+void ParseAXT::getDivergedSites(const vector<uint32_t> &chromosomes, const vector<uint64_t> &starts, const vector<uint64_t> &ends, DivergedSiteSink &sites){
+	sweepRanges_(chromosomes, starts, ends, [&sites](const DivergedSite &site, const size_t &iRange){ sites.put(site, iRange); });
+}
+
+void ParseAXT::getDivergedSites(const vector<uint32_t> &chromosomes, const vector<uint64_t> &starts, const vector<uint64_t> &ends, DivergedSiteSink &sites, const size_t &nThreads){
+	if ( ( starts.size() != chromosomes.size() ) || ( ends.size() != chromosomes.size() ) ) {
+		stringstream wrongThing;
+		wrongThing << "ERROR: the vectors of chromosome IDs (size = ";
+		wrongThing << chromosomes.size();
+		wrongThing << "), start positions (size = ";
+		wrongThing << starts.size();
+		wrongThing << "), and end positions (size = ";
+		wrongThing << ends.size();
+		wrongThing << ") are not the same size in getDivergedSites()";
+		throw wrongThing.str();
+	}
+	vector<AXTchunk> chunks;
+	makeChunks_(chromosomes, nThreads, chunks);
+	vector< vector<size_t> > chunkRanges( chunks.size() );
+	for (size_t iRange = 0; iRange < starts.size(); iRange++) {
+		if (starts[iRange] > ends[iRange]) {
+			stringstream wrongThing;
+			wrongThing << "ERROR: start position (";
+			wrongThing << starts[iRange];
+			wrongThing << ") must not come after the end postion (";
+			wrongThing << ends[iRange];
+			wrongThing << ") in getDivergedSites()";
+			throw wrongThing.str();
 		}
-		if ( (primary == 'N') || (aligned == 'N') ) {  // unkown nucleotide present; ignore
+		const size_t firstChunk = findChunk_(chunks, chromosomes[iRange], starts[iRange]);
+		if ( firstChunk == chunks.size() ) { // chromosome not in the alignment
 			continue;
 		}
-		if (primary == aligned) {
-			uint64_t tmpSz = lengths.size(); // save the pre-insertion size
-			lengths[ chromNames[iPos] ]++;
-			if (lengths.size() > tmpSz) {    // if a new element is added, make sure the count starts at 1
-				lengths[ chromNames[iPos] ] = 1;
-			}
-		} else if ( toupper(primary) == toupper(aligned) ) {  // sometimes there are lower-case bases (low-quality I think)
-			uint64_t tmpSz = lengths.size(); // save the pre-insertion size
-			lengths[ chromNames[iPos] ]++;
-			if (lengths.size() > tmpSz) {    // if a new element is added, make sure the count starts at 1
-				lengths[ chromNames[iPos] ] = 1;
+		const size_t lastChunk = findChunk_(chunks, chromosomes[iRange], ends[iRange]);
+		for (size_t iChunk = firstChunk; iChunk <= lastChunk; iChunk++) {
+			chunkRanges[iChunk].push_back(iRange);
+		}
+	}
+	// chunks are in genome order; each chunk's sites are passed to the sink as soon as all chunks before it are done
+	vector< vector< pair<size_t, DivergedSite> > > found( chunks.size() );
+	vector<bool> done(chunks.size(), false);
+	size_t nextChunk = 0;
+	mutex sinkMutex;
+	runTasks_(chunks.size(), nThreads, [&](ParseAXT &reader, const size_t &iChunk){
+		// ranges are clipped to the chunk; only this task uses the chunk's elements until it is marked done
+		const AXTchunk &chunk = chunks[iChunk];
+		const vector<size_t> &ranges = chunkRanges[iChunk];
+		vector<uint32_t> chunkChromosomes(ranges.size(), chunk.chromosome);
+		vector<uint64_t> chunkStarts;
+		vector<uint64_t> chunkEnds;
+		for (auto &iRange : ranges) {
+			chunkStarts.push_back( std::max(starts[iRange], chunk.start) );
+			chunkEnds.push_back( std::min(ends[iRange], chunk.end) );
+		}
+		vector< pair<size_t, DivergedSite> > &chunkFound = found[iChunk];
+		reader.sweepRanges_(chunkChromosomes, chunkStarts, chunkEnds, [&chunkFound, &ranges](const DivergedSite &site, const size_t &iChunkRange){
+			chunkFound.push_back( pair<size_t, DivergedSite>(ranges[iChunkRange], site) );
+		});
+		lock_guard<mutex> lock(sinkMutex);
+		done[iChunk] = true;
+		while ( (nextChunk < chunks.size()) && done[nextChunk] ) {
+			for (auto &eachFound : found[nextChunk]) {
+				sites.put(eachFound.second, eachFound.first);
 			}
-		} else {  // the sites are divergent
-			stringstream siteInfo;
-			siteInfo << chromNames[iPos] << "\t";
-			siteInfo << positions[iPos] << "\t";
-			siteInfo << primary << "\t" << aligned << "\t";
-			siteInfo << same << "\t";
-			if ( isupper(primary) && isupper(aligned) ) {
-				siteInfo << "1";
-			} else {
-				siteInfo << "0";
+			vector< pair<size_t, DivergedSite> >().swap(found[nextChunk]);
+			nextChunk++;
+		}
+	});
+}
+
+void ParseAXT::countSites(const uint32_t &chromosome, const uint64_t &start, const uint64_t &end, uint64_t &length, uint64_t &nDiverged){
+	if (start > end) {
+		stringstream wrongThing;
+		wrongThing << "ERROR: start position (";
+		wrongThing << start;
+		wrongThing << ") must not come after the end postion (";
+		wrongThing << end;
+		wrongThing << ") in countSites()";
+		throw wrongThing.str();
+	}
+	if (start == 0) {
+		throw string("ERROR: positions start at 1 in countSites()");
+	}
+	length    = 0;
+	nDiverged = 0;
+	if ( chromosome >= blocks_->size() ) { // chromosome not in the alignment
+		return;
+	}
+	if ( callableSites_.size() < blocks_->size() ) {
+		callableSites_.resize( blocks_->size() );
+		divergedSites_.resize( blocks_->size() );
+	}
+	if (callableSites_[chromosome] == nullptr) {
+		buildSiteBits_(chromosome);
+	}
+	length    = callableSites_[chromosome]->count(start - 1, end - 1);
+	nDiverged = divergedSites_[chromosome]->count(start - 1, end - 1);
+}
+
+void ParseAXT::countSites(const vector<uint32_t> &chromosomes, const vector<uint64_t> &starts, const vector<uint64_t> &ends, vector<uint64_t> &lengths, vector<uint64_t> &nDiverged){
+	if ( ( starts.size() != chromosomes.size() ) || ( ends.size() != chromosomes.size() ) ) {
+		stringstream wrongThing;
+		wrongThing << "ERROR: the vectors of chromosome IDs (size = ";
+		wrongThing << chromosomes.size();
+		wrongThing << "), start positions (size = ";
+		wrongThing << starts.size();
+		wrongThing << "), and end positions (size = ";
+		wrongThing << ends.size();
+		wrongThing << ") are not the same size in countSites()";
+		throw wrongThing.str();
+	}
+	lengths.assign(starts.size(), 0);
+	nDiverged.assign(starts.size(), 0);
+	for (size_t iRange = 0; iRange < starts.size(); iRange++) {
+		countSites(chromosomes[iRange], starts[iRange], ends[iRange], lengths[iRange], nDiverged[iRange]);
+	}
+}
+
+bool ParseAXT::checkSite_(const uint32_t &chromosome, const uint64_t &position, DivergedSite &site, bool &diverged){
+	char primary;
+	char aligned;
+	uint16_t same;
+	diverged = false;
+	getSiteStates_(chromosome, position, primary, aligned, same); // will search the .axt records
+	if ( (primary == '-') || (aligned == '-') ) {  // gaps present; ignore
+		return false;
+	}
+	if ( (primary == 'n') || (aligned == 'n') ) {  // unkown nucleotide present; ignore
+		return false;
+	}
+	if ( (primary == 'N') || (aligned == 'N') ) {  // unkown nucleotide present; ignore
+		return false;
+	}
+	if ( toupper(primary) != toupper(aligned) ) {  // the sites are divergent; sometimes there are lower-case bases (low-quality I think)
+		diverged         = true;
+		site.chromosome  = chromosome;
+		site.position    = position;
+		site.primary     = primary;
+		site.aligned     = aligned;
+		site.sameChr     = same;
+		site.goodQuality = ( ( isupper(primary) && isupper(aligned) ) ? 1 : 0 );
+	}
+	return true;
+}
+
+void ParseAXT::makeChunks_(const vector<uint32_t> &chromosomes, const size_t &nThreads, vector<AXTchunk> &chunks) const {
+	const size_t chunksPerThread = 4; // more chunks than threads, so that threads that finish early can take over the remaining work
+	vector<bool> split(blocks_->size(), false);
+	for (auto &eachChr : chromosomes) {
+		if ( eachChr < split.size() ) {
+			split[eachChr] = true;
+		}
+	}
+	// record sizes in bytes come from the distance to the next record in the file
+	vector<size_t> offsets;
+	for (auto &chrBlocks : *blocks_) {
+		for (auto &b : chrBlocks) {
+			offsets.push_back(b.offset);
+		}
+	}
+	std::sort( offsets.begin(), offsets.end() );
+	auto recordBytes = [&](const AXTblock &block){
+		auto next = upper_bound(offsets.begin(), offsets.end(), block.offset);
+		return static_cast<uint64_t>( (next == offsets.end() ? axtFile_.size() : *next) - block.offset );
+	};
+	uint64_t totalBytes = 0;
+	for (uint32_t iChr = 0; iChr < blocks_->size(); iChr++) {
+		if (split[iChr]) {
+			for (auto &b : (*blocks_)[iChr]) {
+				totalBytes += recordBytes(b);
 			}
-			sites.push_back( siteInfo.str() );
+		}
+	}
+	const uint64_t targetBytes = std::max( totalBytes / ( (nThreads == 0 ? 1 : nThreads) * chunksPerThread ), static_cast<uint64_t>(1) );
 
-			uint64_t tmpSz = lengths.size(); // save the pre-insertion size
-			lengths[ chromNames[iPos] ]++;
-			if (lengths.size() > tmpSz) {    // if a new element is added, make sure the count starts at 1
-				lengths[ chromNames[iPos] ] = 1;
+	chunks.clear();
+	for (uint32_t iChr = 0; iChr < blocks_->size(); iChr++) {
+		if (!split[iChr]) {
+			continue;
+		}
+		const vector<AXTblock> &chrBlocks = (*blocks_)[iChr];
+		AXTchunk chunk;
+		chunk.chromosome = iChr;
+		chunk.firstBlock = 0;
+		chunk.start      = 1;
+		uint64_t chunkBytes = 0;
+		for (size_t iBlock = 0; iBlock < chrBlocks.size(); iBlock++) {
+			chunkBytes += recordBytes(chrBlocks[iBlock]);
+			if ( (chunkBytes >= targetBytes) || (iBlock + 1 == chrBlocks.size()) ) {
+				chunk.lastBlock = iBlock + 1;
+				chunk.end       = ( (iBlock + 1 == chrBlocks.size()) ? std::numeric_limits<uint64_t>::max() : chrBlocks[iBlock].primaryEnd );
+				chunks.push_back(chunk);
+				chunk.firstBlock = iBlock + 1;
+				chunk.start      = chunk.end + 1;
+				chunkBytes       = 0;
 			}
 		}
 	}
 }
 
-void ParseAXT::getOutgroupState(const string &chromName, const uint64_t &position, string &site){
-	if (chromName == foundChr_) { // this chromosome already completed; site unavailable
-		site = "N00";
-		return;
+size_t ParseAXT::findChunk_(const vector<AXTchunk> &chunks, const uint32_t &chromosome, const uint64_t &position) const {
+	// first chunk that ends at or after the position
+	auto chunkIt = std::lower_bound(chunks.begin(), chunks.end(), pair<uint32_t, uint64_t>(chromosome, position), [](const AXTchunk &chunk, const pair<uint32_t, uint64_t> &value){
+		return (chunk.chromosome < value.first) || ( (chunk.chromosome == value.first) && (chunk.end < value.second) );
+	});
+	if ( ( chunkIt == chunks.end() ) || (chunkIt->chromosome != chromosome) ) {
+		return chunks.size();
+	}
+	return static_cast<size_t>( chunkIt - chunks.begin() );
+}
+
+void ParseAXT::runTasks_(const size_t &nTasks, const size_t &nThreads, const std::function<void(ParseAXT &, const size_t &)> &process) const {
+	const size_t nWorkers = std::min( (nThreads == 0 ? 1 : nThreads), nTasks );
+	atomic<size_t> nextTask(0);
+	mutex errorMutex;
+	bool abort = false;
+	string errorMessage;
+	auto fail = [&](const string &message){
+		lock_guard<mutex> lock(errorMutex);
+		if (!abort) {
+			abort        = true;
+			errorMessage = message;
+		}
+	};
+
+	vector<thread> workers;
+	for (size_t iWorker = 0; iWorker < nWorkers; iWorker++) {
+		workers.push_back( thread([&](){
+			try {
+				ParseAXT reader(*this);
+				for (size_t iTask = nextTask++; iTask < nTasks; iTask = nextTask++) {
+					{
+						lock_guard<mutex> lock(errorMutex);
+						if (abort) {
+							return;
+						}
+					}
+					process(reader, iTask);
+				}
+			} catch(string &error) {
+				fail(error);
+			} catch(std::exception &error) {
+				fail( string("ERROR: failed to scan ") + fileName_ + ": " + error.what() );
+			}
+		}) );
+	}
+	for (auto &eachWorker : workers) {
+		eachWorker.join();
 	}
+	if (abort) {
+		throw errorMessage;
+	}
+}
+
+void ParseAXT::getOutgroupState(const uint32_t &chromosome, const uint64_t &position, string &site){
 	char primary;
 	char aligned;
 	uint16_t same;
-	getSiteStates_(chromName, position, primary, aligned, same); // will search the .axt records
+	getSiteStates_(chromosome, position, primary, aligned, same); // will search the .axt records
 	if ( (aligned == '-') || (aligned == 'n') || (aligned == 'N') ) {
 		site = "N0";
 		if (same) {
@@ -245,156 +550,692 @@ void ParseAXT::getOutgroupState(const string &chromName, const uint64_t &positio
 	}
 }
 
-void ParseAXT::getNextRecord_(){
-	string curLine("");
-	while(getline(axtFile_, curLine)){
-		if (curLine[0] == '#') {
+uint8_t ParseAXT::getOutgroupState(const uint32_t &chromosome, const uint64_t &position){
+	char primary;
+	char aligned;
+	uint16_t same;
+	getSiteStates_(chromosome, position, primary, aligned, same);
+	return OutgroupStates::encode(aligned, same);
+}
+
+bool ParseAXT::readHeader_(){
+	const char *lineStart = nullptr;
+	const char *lineEnd   = nullptr;
+	bool foundHeader      = false;
+	size_t lineOffset     = nextByte_;
+	while( getNextLine_(lineStart, lineEnd) ){
+		if (lineStart == lineEnd) {
+			lineOffset = nextByte_;
 			continue;
-		} else if (curLine == "") {
+		} else if (lineStart[0] == '#') {
+			lineOffset = nextByte_;
 			continue;
 		} else {
+			foundHeader = true;
 			break;
 		}
 	}
-	if (curLine == ""){
-		throw string("End of file");
+	if (!foundHeader){
+		return false;
 	}
+	recordOffset_ = lineOffset;
 
-	// we have a non-empty line, presumably the meta-data header for .axt
-	stringstream metaSS(curLine);
-	vector<string> fields;
-	string value;
-	while(metaSS >> value){ // makes sure we don't have anything extra at the end
-		fields.push_back(value);
+	// we have a non-empty line, presumably the meta-data header for .axt; split it into fields in place
+	const size_t nFields = 9;
+	const char *fieldStart[nFields];
+	size_t fieldLength[nFields];
+	size_t iField = 0;
+	const char *curChar = lineStart;
+	while (curChar != lineEnd) {
+		if ( isspace(*curChar) ) {
+			++curChar;
+			continue;
+		}
+		if (iField == nFields) { // makes sure we don't have anything extra at the end
+			throw string("Wrong number of fields in .axt metada");
+		}
+		fieldStart[iField] = curChar;
+		while ( (curChar != lineEnd) && !isspace(*curChar) ) {
+			++curChar;
+		}
+		fieldLength[iField] = static_cast<size_t>(curChar - fieldStart[iField]);
+		iField++;
 	}
-	if (fields.size() != 9) {
+	if (iField != nFields) {
 		throw string("Wrong number of fields in .axt metada");
 	}
-	if ( (fields[1][0] != 'c') || (fields[1][1] != 'h') || (fields[1][2] != 'r') ) { // do not have "chr" at the beginning of the chromosome field
-		if ( (fields[1][0] != 'X') || (fields[1][0] != '2') || (fields[1][0] != '3') || (fields[1][0] != '4') ){
-			string wrongThing = "Wrong chromosome field: " + fields[1];
-			throw wrongThing;
-		} else {
-			fields[1] = "chr" + fields[1];
-		}
+	if (chrID_.compare(0, string::npos, fieldStart[1], fieldLength[1]) != 0) {
+		chrID_ = GenomeDictionary::canonicalName(fieldStart[1], fieldLength[1]);
 	}
-	string tmpChrID = chrID_;
-	chrID_ = fields[1];
 
-	uint64_t tmpStart = primaryStart_;
-	primaryStart_ = strtoul(fields[2].c_str(), NULL, 0);
+	parseUnsigned(fieldStart[2], fieldStart[2] + fieldLength[2], primaryStart_);
 	if (primaryStart_ == 0) {
-		string wrongThing = "Wrong primary sequence start: " + fields[2];
-		throw wrongThing;
-	} else if ( (primaryStart_ <= tmpStart) && (tmpChrID == chrID_) ) { // the records should be in order of increasing primary sequence position, unless there is a chromosome switch
-		string wrongThing = "Primary start of the current record (" + fields[2] + ") not greater than the perivous record";
+		string wrongThing = "Wrong primary sequence start: " + string(fieldStart[2], fieldLength[2]);
 		throw wrongThing;
 	}
-	primaryEnd_ = strtoul(fields[3].c_str(), NULL, 0);
+	parseUnsigned(fieldStart[3], fieldStart[3] + fieldLength[3], primaryEnd_);
 	if (primaryEnd_ == 0) {
-		string wrongThing = "Wrong primary sequence end: " + fields[3];
+		string wrongThing = "Wrong primary sequence end: " + string(fieldStart[3], fieldLength[3]);
 		throw wrongThing;
 	} else if (primaryEnd_ < primaryStart_) {  // strictly less because there are cases where only one nucleotide is in a record
 		stringstream wrongThing;
 		wrongThing << "Position of the end of primary sequence (";
-		wrongThing << fields[3];
+		wrongThing << string(fieldStart[3], fieldLength[3]);
 		wrongThing << ") not greater than the position of the start: ";
 		wrongThing << primaryStart_;
-		wrongThing << " (if the last number is huge, the original number was likely negative)";
 		throw wrongThing.str();
 	}
 
-	if ( (fields[4][0] != 'c') || (fields[4][1] != 'h') || (fields[4][2] != 'r') ) { // do not have "chr" at the beginning of the chromosome field
-		if ( (fields[4][0] != 'X') || (fields[4][0] != '2') || (fields[4][0] != '3') || (fields[4][0] != '4') ){
-			string wrongThing = "Wrong aligned chromosome field: " + fields[4];
-			throw wrongThing;
-		} else {
-			fields[4] = "chr" + fields[4];
-		}
-	}
-	sameChr_ = (fields[4] == fields[1] ? 1 : 0);
+	sameChr_ = ( ( (fieldLength[4] == fieldLength[1]) && (strncmp(fieldStart[4], fieldStart[1], fieldLength[1]) == 0) ) ? 1 : 0 );
 
-	alignedStart_ = strtoul(fields[5].c_str(), NULL, 0);
+	parseUnsigned(fieldStart[5], fieldStart[5] + fieldLength[5], alignedStart_);
 	if (alignedStart_ == 0) {
-		string wrongThing = "Wrong primary sequence start: " + fields[5];
+		string wrongThing = "Wrong primary sequence start: " + string(fieldStart[5], fieldLength[5]);
 		throw wrongThing;
 	}
-	alignedEnd_ = strtoul(fields[6].c_str(), NULL, 0);
+	parseUnsigned(fieldStart[6], fieldStart[6] + fieldLength[6], alignedEnd_);
 	if (alignedEnd_ == 0) {
-		string wrongThing = "Wrong primary sequence end: " + fields[6];
+		string wrongThing = "Wrong primary sequence end: " + string(fieldStart[6], fieldLength[6]);
 		throw wrongThing;
 	}
 
-	// now just read the sequences
-	if(axtFile_.eof()){
+	return true;
+}
+
+void ParseAXT::readSequences_(){
+	const char *lineStart = nullptr;
+	const char *lineEnd   = nullptr;
+	if ( !getNextLine_(lineStart, lineEnd) ){
 		throw string("End of file reached before primary sequence read");
 	}
-	getline(axtFile_, primarySeq_);
+	primarySeq_ = lineStart;
+	seqLength_  = static_cast<size_t>(lineEnd - lineStart);
 
-	if(axtFile_.eof()){
+	if ( !getNextLine_(lineStart, lineEnd) ){
 		throw string("End of file reached before aligned sequence read");
 	}
-	getline(axtFile_, alignSeq_);
-	if ( primarySeq_.size() != alignSeq_.size() ) {
-		string wrongThing = "The sequence strings for record #" + fields[0] + " are not equal length";
-		throw wrongThing;
+	alignSeq_ = lineStart;
+	if ( static_cast<size_t>(lineEnd - lineStart) != seqLength_ ) {
+		stringstream wrongThing;
+		wrongThing << "The sequence strings for the record starting at ";
+		wrongThing << chrID_ << ":" << primaryStart_;
+		wrongThing << " are not equal length";
+		throw wrongThing.str();
 	}
 }
 
-void ParseAXT::getSiteStates_(const string &chromosome, const uint64_t &position, char &primaryState, char &alignedState, uint16_t &sameChromosome){
-	bool noneFound = true;
-	bool correctChrFound = false;
-	while(axtFile_){
-		if (chrID_ != chromosome) {
-			if (correctChrFound) { // blew past the correct chromosome without finding the position (maybe not covered)
-				primaryState   = '-';
-				alignedState   = '-';
-				sameChromosome = 0;
-				noneFound      = false;
-				if (foundChr_ != chromosome) {
-					foundChr_ = chromosome;
-				}
-				return;
-			}
-			getNextRecord_();
+void ParseAXT::skipSequences_(){
+	const size_t minLength = static_cast<size_t>(primaryEnd_ - primaryStart_ + 1);
+	if ( ( nextByte_ >= axtFile_.size() ) || (axtFile_.size() - nextByte_ < minLength) ) {
+		throw string("End of file reached before primary sequence read");
+	}
+	const char *lineStart = axtFile_.data() + nextByte_;
+	const char *lineEnd   = static_cast<const char*>( memchr(lineStart + minLength, '\n', axtFile_.size() - nextByte_ - minLength) );
+	if (lineEnd == nullptr) {
+		throw string("End of file reached before aligned sequence read");
+	}
+	const size_t lineLength = static_cast<size_t>(lineEnd - lineStart);
+	const size_t alignedEnd = nextByte_ + 2*lineLength + 1; // one past the last character of the aligned line
+	if ( ( alignedEnd > axtFile_.size() ) || ( ( alignedEnd < axtFile_.size() ) && (axtFile_.data()[alignedEnd] != '\n') ) ) {
+		readSequences_(); // reads the lines in full to report what is wrong
+		stringstream wrongThing;
+		wrongThing << "The record starting at ";
+		wrongThing << chrID_ << ":" << primaryStart_;
+		wrongThing << " has fewer nucleotides than its header implies";
+		throw wrongThing.str();
+	}
+	nextByte_ = ( alignedEnd < axtFile_.size() ? alignedEnd + 1 : alignedEnd );
+}
+
+void ParseAXT::buildIndex_(){
+	genome_.clear();
+	vector< vector<AXTblock> > blocks;
+	nextByte_ = 0;
+	while ( readHeader_() ) {
+		AXTblock block;
+		block.primaryStart = primaryStart_;
+		block.primaryEnd   = primaryEnd_;
+		block.offset       = recordOffset_;
+		addBlock_(chrID_, block, blocks);
+		skipSequences_();
+	}
+	blocks_ = std::make_shared< const vector< vector<AXTblock> > >( std::move(blocks) );
+	// the cursor is at the end of the file, so no record is current; otherwise loading the last record (e.g., the only one) would be skipped
+	recordOffset_ = 0;
+	primaryEnd_   = 0;
+}
+
+bool ParseAXT::loadIndex_(const string &indexFileName){
+	MappedFile indexFile(indexFileName);
+	if (indexFile.size() == 0) {
+		throw string("ERROR: ") + indexFileName + " is empty";
+	}
+	const char *curChar = indexFile.data();
+	const char *fileEnd = indexFile.data() + indexFile.size();
+	const char *lineEnd = static_cast<const char*>( memchr(curChar, '\n', indexFile.size()) );
+	if ( (lineEnd == nullptr) || (strncmp(curChar, "#AXTI\t", 6) != 0) ) {
+		throw string("ERROR: ") + indexFileName + " is not an .axt index file";
+	}
+	uint64_t axtSize     = 0;
+	uint64_t axtModified = 0; // indexes saved without the modification time are always stale
+	curChar = parseUnsigned(curChar + 6, lineEnd, axtSize);
+	if (curChar != lineEnd) {
+		parseUnsigned(curChar + 1, lineEnd, axtModified);
+	}
+	if ( ( axtSize != static_cast<uint64_t>( axtFile_.size() ) ) || ( axtModified != axtFile_.modified() ) ) { // the .axt file changed after the index was saved
+		return false;
+	}
+	genome_.clear();
+	vector< vector<AXTblock> > blocks;
+	string chromosome;
+	curChar = lineEnd + 1;
+	while (curChar < fileEnd) {
+		lineEnd = static_cast<const char*>( memchr( curChar, '\n', static_cast<size_t>(fileEnd - curChar) ) );
+		if (lineEnd == nullptr) {
+			lineEnd = fileEnd;
+		}
+		if (lineEnd == curChar) {
+			curChar = lineEnd + 1;
 			continue;
 		}
-		correctChrFound = true;
-		if (primaryEnd_ >= position) {
-			if (position < primaryStart_) {  // our position may fall into a gap between alignment chunks; will return values that will be filtered downstream
-				primaryState   = '-';
-				alignedState   = '-';
-				sameChromosome = 0;
-				noneFound      = false;
-				return;
+		const char *tab = static_cast<const char*>( memchr( curChar, '\t', static_cast<size_t>(lineEnd - curChar) ) );
+		if (tab == nullptr) {
+			throw string("ERROR: malformed line in the .axt index file ") + indexFileName;
+		}
+		chromosome.assign(curChar, tab);
+		AXTblock block;
+		uint64_t value;
+		curChar = parseUnsigned(tab + 1, lineEnd, block.primaryStart);
+		curChar = parseUnsigned(curChar + 1, lineEnd, block.primaryEnd);
+		curChar = parseUnsigned(curChar + 1, lineEnd, value);
+		block.offset = static_cast<size_t>(value);
+		if ( (curChar != lineEnd) || (block.primaryStart == 0) || ( block.offset >= axtFile_.size() ) ) {
+			throw string("ERROR: malformed line in the .axt index file ") + indexFileName;
+		}
+		addBlock_(chromosome, block, blocks);
+		curChar = lineEnd + 1;
+	}
+	blocks_ = std::make_shared< const vector< vector<AXTblock> > >( std::move(blocks) );
+	return true;
+}
+
+void ParseAXT::addBlock_(const string &chromosome, const AXTblock &block, vector< vector<AXTblock> > &blocks){
+	const uint32_t chrIdx = genome_.intern(chromosome);
+	if ( chrIdx == blocks.size() ) {
+		blocks.push_back( vector<AXTblock>() );
+	}
+	vector<AXTblock> &chrBlocks = blocks[chrIdx];
+	if ( !chrBlocks.empty() && (block.primaryStart <= chrBlocks.back().primaryStart) ) { // the records should be in order of increasing primary sequence position within a chromosome
+		stringstream wrongThing;
+		wrongThing << "Primary start of the record at ";
+		wrongThing << chromosome << ":" << block.primaryStart;
+		wrongThing << " not greater than the perivous record on the same chromosome";
+		throw wrongThing.str();
+	}
+	chrBlocks.push_back(block);
+}
+
+bool ParseAXT::findBlock_(const uint32_t &chromosome, const uint64_t &position, size_t &blockIdx) const {
+	if ( chromosome >= blocks_->size() ) { // also catches GenomeDictionary::missing
+		return false;
+	}
+	const vector<AXTblock> &chrBlocks = (*blocks_)[chromosome];
+	// first record that starts after the position; the one before it may contain the position
+	auto blockIt = upper_bound(chrBlocks.begin(), chrBlocks.end(), position, [](const uint64_t &pos, const AXTblock &block){ return pos < block.primaryStart; });
+	if ( ( blockIt != chrBlocks.begin() ) && ( (blockIt - 1)->primaryEnd >= position ) ) {
+		--blockIt;
+	}
+	blockIdx = static_cast<size_t>( blockIt - chrBlocks.begin() );
+	return true;
+}
+
+void ParseAXT::loadRecord_(const AXTblock &block){
+	if ( (primaryEnd_ != 0) && (recordOffset_ == block.offset) ) { // a record is current, and it is this one
+		return;
+	}
+	sequencesLoaded_ = false;
+	primarySeq_      = nullptr;
+	alignSeq_        = nullptr;
+	packedRecord_    = nullptr;
+	seqLength_       = 0;
+	if ( !packed_->empty() ) { // the sequences are read from the packed copy; the header values come from the index
+		packedRecord_ = packed_->find(block.offset);
+		if (packedRecord_ == nullptr) {
+			throw string("ERROR: the packed alignment does not match the .axt index; rebuild it");
+		}
+		recordOffset_ = block.offset;
+		primaryStart_ = block.primaryStart;
+		primaryEnd_   = block.primaryEnd;
+		sameChr_      = packedRecord_->sameChr;
+		return;
+	}
+	nextByte_ = block.offset;
+	if ( !readHeader_() ) {
+		throw string("End of file");
+	}
+	if ( (recordOffset_ != block.offset) || (primaryStart_ != block.primaryStart) || (primaryEnd_ != block.primaryEnd) ) {
+		throw string("ERROR: the .axt index does not match the records in the file; rebuild the index");
+	}
+}
+
+void ParseAXT::loadSequences_(){
+	if (sequencesLoaded_) {
+		return;
+	}
+	if (packedRecord_ != nullptr) {
+		seqLength_ = static_cast<size_t>(packedRecord_->nColumns);
+	} else {
+		readSequences_(); // loadRecord_() left nextByte_ at the primary sequence
+	}
+	indexGaps_();
+	sequencesLoaded_ = true;
+}
+
+void ParseAXT::saveIndex(const string &indexFileName){
+	fstream indexFile;
+	try {
+		indexFile.exceptions(fstream::badbit | fstream::failbit);
+		indexFile.open(indexFileName.c_str(), ios::out | ios::trunc);
+		indexFile << "#AXTI\t" << axtFile_.size() << "\t" << axtFile_.modified() << "\n";
+		for (uint32_t iChr = 0; iChr < blocks_->size(); iChr++) {
+			for (auto &b : (*blocks_)[iChr]) {
+				indexFile << genome_.name(iChr) << "\t" << b.primaryStart << "\t" << b.primaryEnd << "\t" << b.offset << "\n";
+			}
+		}
+		indexFile.close();
+	} catch(system_error &error) {
+		string message = "ERROR: cannot write the index file " + indexFileName + ": " + error.code().message();
+		throw message;
+	}
+}
+
+void ParseAXT::packAlignment(){
+	if ( !packed_->empty() ) {
+		return;
+	}
+	// records are packed in file order
+	vector<AXTblock> fileBlocks;
+	for (auto &chrBlocks : *blocks_) {
+		fileBlocks.insert( fileBlocks.end(), chrBlocks.begin(), chrBlocks.end() );
+	}
+	std::sort(fileBlocks.begin(), fileBlocks.end(), [](const AXTblock &first, const AXTblock &second){ return first.offset < second.offset; });
+	PackedAlignment packed;
+	for (auto &b : fileBlocks) {
+		loadRecord_(b);
+		loadSequences_();
+		packed.addRecord(b.offset, primarySeq_, alignSeq_, seqLength_, sameChr_);
+	}
+	packed_ = std::make_shared<const PackedAlignment>( std::move(packed) );
+}
+
+void ParseAXT::savePackedAlignment(const string &packedFileName){
+	packAlignment();
+	packed_->save( packedFileName, static_cast<uint64_t>( axtFile_.size() ), axtFile_.modified() );
+}
+
+void ParseAXT::saveOutgroupStates(const string &stateFileName, const size_t &nThreads){
+	fstream stateFile;
+	try {
+		stateFile.exceptions(fstream::badbit | fstream::failbit);
+		stateFile.open(stateFileName.c_str(), ios::out | ios::trunc | ios::binary);
+		// the last covered position of each chromosome sets the table length
+		vector<uint64_t> lengths( blocks_->size(), 0 );
+		for (uint32_t iChr = 0; iChr < blocks_->size(); iChr++) {
+			for (auto &b : (*blocks_)[iChr]) {
+				lengths[iChr] = std::max(lengths[iChr], b.primaryEnd);
 			}
-			uint64_t truePos = primaryStart_;                   // this is the genomic position (with gaps eliminated)
-			for (size_t i = 0; i < primarySeq_.size() ; i++) {  // string length equality already checked in getNextRecord_()
-				if (primarySeq_[i] == '-') {
-					continue;
-				}
-				if (truePos == position) {
-					primaryState   = primarySeq_[i];
-					alignedState   = alignSeq_[i];   // may be a gap, that can be checked in post-processing
-					sameChromosome = sameChr_;
-					noneFound      = false;
-					return;
+		}
+		stateFile << "#AXTANC\t" << axtFile_.size() << "\t" << blocks_->size() << "\t" << axtFile_.modified() << "\n";
+		for (uint32_t iChr = 0; iChr < blocks_->size(); iChr++) {
+			stateFile << genome_.name(iChr) << "\t" << lengths[iChr] << "\n";
+		}
+		vector<uint8_t> states;
+		vector<AXTchunk> chunks;
+		for (uint32_t iChr = 0; iChr < blocks_->size(); iChr++) {
+			states.assign(lengths[iChr], 0);
+			if (nThreads > 1) { // records do not overlap, so the chunks fill separate parts of the table
+				makeChunks_(vector<uint32_t>(1, iChr), nThreads, chunks);
+				runTasks_(chunks.size(), nThreads, [&](ParseAXT &reader, const size_t &iChunk){
+					for (size_t iBlock = chunks[iChunk].firstBlock; iBlock < chunks[iChunk].lastBlock; iBlock++) {
+						reader.projectRecord_(iChr, (*blocks_)[iChr][iBlock], states);
+					}
+				});
+			} else {
+				for (auto &b : (*blocks_)[iChr]) {
+					projectRecord_(iChr, b, states);
 				}
-				truePos++;
 			}
-			break;
-		} else {
-			getNextRecord_();
+			stateFile.write( reinterpret_cast<const char*>( states.data() ), static_cast<std::streamsize>( states.size() ) );
 		}
+		stateFile.close();
+	} catch(system_error &error) {
+		string message = "ERROR: cannot write the outgroup state file " + stateFileName + ": " + error.code().message();
+		throw message;
+	}
+}
 
+void ParseAXT::projectRecord_(const uint32_t &chromosome, const AXTblock &block, vector<uint8_t> &states){
+	loadRecord_(block);
+	loadSequences_();
+	uint64_t position = primaryStart_;
+	for (size_t iCol = 0; (iCol < seqLength_) && (position <= primaryEnd_); iCol++) {
+		if (primaryNucleotide_(iCol) == '-') {
+			continue;
+		}
+		states[position - 1] = OutgroupStates::encode(alignedNucleotide_(iCol), sameChr_);
+		position++;
 	}
-	if (noneFound) {
+	if (position <= primaryEnd_) {
 		stringstream wrongThing;
-		wrongThing << "Reached the end of file before finding a record for positition ";
+		wrongThing << "The record covering positition ";
 		wrongThing << position;
 		wrongThing << " on chromosome ";
-		wrongThing << chromosome;
+		wrongThing << genome_.name(chromosome);
+		wrongThing << " has fewer nucleotides than its header implies";
 		throw wrongThing.str();
 	}
 }
 
+bool ParseAXT::getNextLine_(const char *&lineStart, const char *&lineEnd){
+	if ( nextByte_ >= axtFile_.size() ) {
+		return false;
+	}
+	lineStart = axtFile_.data() + nextByte_;
+	const size_t remaining = axtFile_.size() - nextByte_;
+	lineEnd   = static_cast<const char*>( memchr(lineStart, '\n', remaining) );
+	if (lineEnd == nullptr) { // last line without a newline
+		lineEnd    = lineStart + remaining;
+		nextByte_  = axtFile_.size();
+	} else {
+		nextByte_ += static_cast<size_t>(lineEnd - lineStart) + 1;
+	}
+	return true;
+}
+
+void ParseAXT::indexGaps_(){
+	runPositions_.clear();
+	runColumns_.clear();
+	if (packedRecord_ != nullptr) {
+		if ( masks_.size() < (seqLength_ + 63)/64 ) {
+			masks_.resize( (seqLength_ + 63)/64 );
+		}
+		packed_->plane(*packedRecord_, PackedAlignment::primaryGap, 0, seqLength_, masks_.data());
+	}
+	uint64_t truePos = primaryStart_; // this is the genomic position (with gaps eliminated)
+	bool inGap       = true;
+	for (size_t i = 0; i < seqLength_; i++) {
+		const bool gap = ( (packedRecord_ != nullptr) ? ( (masks_[i/64] >> (i % 64)) & 1 ) : (primarySeq_[i] == '-') );
+		if (gap) {
+			inGap = true;
+			continue;
+		}
+		if (inGap) {
+			runPositions_.push_back(truePos);
+			runColumns_.push_back(i);
+			inGap = false;
+		}
+		truePos++;
+	}
+	// sentinel: one past the last position covered by the record
+	runPositions_.push_back(truePos);
+	runColumns_.push_back(seqLength_);
+}
+
+size_t ParseAXT::column_(const uint64_t &position) const {
+	if ( position >= runPositions_.back() ) {
+		return seqLength_;
+	}
+	// first run that starts after the position; the one before it contains the position
+	auto runIt = upper_bound(runPositions_.begin(), runPositions_.end(), position);
+	const size_t iRun = static_cast<size_t>(runIt - runPositions_.begin()) - 1;
+	return runColumns_[iRun] + static_cast<size_t>(position - runPositions_[iRun]);
+}
+
+size_t ParseAXT::classifyColumns_(const uint32_t &chromosome, const uint64_t &from, const uint64_t &to, size_t &firstCol){
+	firstCol = column_(from);
+	const size_t lastCol  = column_(to);
+	if (lastCol >= seqLength_) {
+		stringstream wrongThing;
+		wrongThing << "The record covering positition ";
+		wrongThing << to;
+		wrongThing << " on chromosome ";
+		wrongThing << genome_.name(chromosome);
+		wrongThing << " has fewer nucleotides than its header implies";
+		throw wrongThing.str();
+	}
+	// classify all columns of the range at once; the first and last columns are not primary sequence gaps
+	const size_t nColumns = lastCol - firstCol + 1;
+	const size_t nWords   = (nColumns + 63)/64;
+	if (masks_.size() < 5*nWords) {
+		masks_.resize(5*nWords);
+	}
+	uint64_t *primaryGap = masks_.data();
+	uint64_t *alignedGap = primaryGap + nWords;
+	uint64_t *unknown    = alignedGap + nWords;
+	uint64_t *match      = unknown + nWords;
+	uint64_t *upper      = match + nWords;
+	if (packedRecord_ != nullptr) {
+		packed_->masks(*packedRecord_, firstCol, nColumns, primaryGap, alignedGap, unknown, match, upper);
+	} else {
+		alignmentMasks(primarySeq_ + firstCol, alignSeq_ + firstCol, nColumns, primaryGap, alignedGap, unknown, match, upper);
+	}
+	return nColumns;
+}
+
+void ParseAXT::walkColumns_(const uint64_t &from, const size_t &nColumns, const std::function<void(const size_t &, const uint64_t &, const uint64_t &, const uint64_t &)> &visit) const {
+	const size_t nWords = (nColumns + 63)/64;
+	const uint64_t *primaryGap = masks_.data();
+	const uint64_t *alignedGap = primaryGap + nWords;
+	const uint64_t *unknown    = alignedGap + nWords;
+
+	uint64_t wordSite = from; // position of the first primary nucleotide in the current word
+	for (size_t iWord = 0; iWord < nWords; iWord++) {
+		const size_t wordColumns = ( (iWord + 1 == nWords) ? nColumns - 64*iWord : 64 );
+		const uint64_t inRange   = ( (wordColumns == 64) ? ~static_cast<uint64_t>(0) : (static_cast<uint64_t>(1) << wordColumns) - 1 );
+		const uint64_t nucleotide = inRange & ~primaryGap[iWord];
+		const uint64_t good       = nucleotide & ~alignedGap[iWord] & ~unknown[iWord]; // gaps or unkown nucleotides present; ignore
+		visit(iWord, nucleotide, good, wordSite);
+		wordSite += static_cast<uint64_t>( __builtin_popcountll(nucleotide) );
+	}
+}
+
+void ParseAXT::scanRecord_(const uint32_t &chromosome, const uint64_t &from, const uint64_t &to, vector<DivergedSite> &sites, uint64_t &length){
+	size_t firstCol;
+	const size_t nColumns = classifyColumns_(chromosome, from, to, firstCol);
+	const size_t nWords   = (nColumns + 63)/64;
+	const uint64_t *match = masks_.data() + 3*nWords;
+	const uint64_t *upper = match + nWords;
+	walkColumns_(from, nColumns, [&](const size_t &iWord, const uint64_t &nucleotide, const uint64_t &good, const uint64_t &wordSite){
+		length += static_cast<uint64_t>( __builtin_popcountll(good) );
+		uint64_t diverged = good & ~match[iWord]; // sometimes there are lower-case bases (low-quality I think), so matching ignores case
+		while (diverged) {
+			const unsigned bit  = static_cast<unsigned>( __builtin_ctzll(diverged) );
+			const uint64_t below = (static_cast<uint64_t>(1) << bit) - 1;
+			const size_t iCol    = firstCol + 64*iWord + bit;
+			DivergedSite site;
+			site.chromosome  = chromosome;
+			site.position    = wordSite + static_cast<uint64_t>( __builtin_popcountll(nucleotide & below) );
+			site.primary     = primaryNucleotide_(iCol);
+			site.aligned     = alignedNucleotide_(iCol);
+			site.sameChr     = sameChr_;
+			site.goodQuality = static_cast<uint16_t>( (upper[iWord] >> bit) & 1 );
+			sites.push_back(site);
+			diverged &= diverged - 1;
+		}
+	});
+}
+
+void ParseAXT::sweepRanges_(const vector<uint32_t> &chromosomes, const vector<uint64_t> &starts, const vector<uint64_t> &ends, const std::function<void(const DivergedSite &, const size_t &)> &found){
+	if ( ( starts.size() != chromosomes.size() ) || ( ends.size() != chromosomes.size() ) ) {
+		stringstream wrongThing;
+		wrongThing << "ERROR: the vectors of chromosome IDs (size = ";
+		wrongThing << chromosomes.size();
+		wrongThing << "), start positions (size = ";
+		wrongThing << starts.size();
+		wrongThing << "), and end positions (size = ";
+		wrongThing << ends.size();
+		wrongThing << ") are not the same size in getDivergedSites()";
+		throw wrongThing.str();
+	}
+	vector<size_t> order( starts.size() );
+	for (size_t iRange = 0; iRange < order.size(); iRange++) {
+		if (starts[iRange] > ends[iRange]) {
+			stringstream wrongThing;
+			wrongThing << "ERROR: start position (";
+			wrongThing << starts[iRange];
+			wrongThing << ") must not come after the end postion (";
+			wrongThing << ends[iRange];
+			wrongThing << ") in getDivergedSites()";
+			throw wrongThing.str();
+		}
+		order[iRange] = iRange;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](const size_t &first, const size_t &second){
+		return (chromosomes[first] < chromosomes[second]) || ( (chromosomes[first] == chromosomes[second]) && (starts[first] < starts[second]) );
+	});
+
+	vector< pair<uint64_t, size_t> > open; // min-heap of (end, range index) of the ranges that contain the current segment
+	const std::greater< pair<uint64_t, size_t> > endOrder;
+	vector<size_t> openRanges;              // indexes of the open ranges, in input order
+	vector<DivergedSite> pieceSites;
+	size_t iOrder = 0;
+	while ( iOrder < order.size() ) {
+		const uint32_t chromosome = chromosomes[ order[iOrder] ];
+		uint64_t segmentStart   = starts[ order[iOrder] ];
+		while ( ( (iOrder < order.size()) && (chromosomes[ order[iOrder] ] == chromosome) ) || !open.empty() ) {
+			if ( open.empty() ) {
+				segmentStart = starts[ order[iOrder] ];
+			}
+			while ( (iOrder < order.size()) && (chromosomes[ order[iOrder] ] == chromosome) && (starts[ order[iOrder] ] <= segmentStart) ) {
+				open.push_back( pair<uint64_t, size_t>(ends[ order[iOrder] ], order[iOrder]) );
+				std::push_heap(open.begin(), open.end(), endOrder);
+				iOrder++;
+			}
+			// the segment ends where the first open range ends or the next range starts
+			uint64_t segmentEnd = open.front().first;
+			if ( (iOrder < order.size()) && (chromosomes[ order[iOrder] ] == chromosome) && (starts[ order[iOrder] ] <= segmentEnd) ) {
+				segmentEnd = starts[ order[iOrder] ] - 1;
+			}
+			openRanges.clear();
+			for (auto &eachOpen : open) {
+				openRanges.push_back(eachOpen.second);
+			}
+			std::sort( openRanges.begin(), openRanges.end() );
+			// scan long segments in pieces, so that only a piece's sites are held at a time
+			uint64_t pieceStart = segmentStart;
+			while (true) {
+				const uint64_t pieceEnd = ( (segmentEnd - pieceStart < sweepPiece_) ? segmentEnd : pieceStart + sweepPiece_ - 1 );
+				pieceSites.clear();
+				uint64_t pieceLength = 0; // not used: range lengths come from countSites()
+				scanRange_(chromosome, pieceStart, pieceEnd, pieceSites, pieceLength);
+				for (auto &eachSite : pieceSites) {
+					for (auto &iRange : openRanges) {
+						found(eachSite, iRange);
+					}
+				}
+				if (pieceEnd == segmentEnd) {
+					break;
+				}
+				pieceStart = pieceEnd + 1;
+			}
+			segmentStart = segmentEnd + 1;
+			while ( !open.empty() && (open.front().first < segmentStart) ) {
+				std::pop_heap(open.begin(), open.end(), endOrder);
+				open.pop_back();
+			}
+		}
+	}
+}
+
+void ParseAXT::scanRange_(const uint32_t &chromosome, const uint64_t &start, const uint64_t &end, vector<DivergedSite> &sites, uint64_t &length){
+	size_t blockIdx;
+	if ( !findBlock_(chromosome, start, blockIdx) ) { // chromosome not in the alignment
+		return;
+	}
+	const vector<AXTblock> &chrBlocks = (*blocks_)[chromosome];
+	uint64_t iSite = start;
+	for (; blockIdx < chrBlocks.size(); blockIdx++) {
+		const AXTblock &block = chrBlocks[blockIdx];
+		if (block.primaryEnd < iSite) {
+			continue;
+		}
+		if (iSite < block.primaryStart) { // positions in the gap between alignment chunks are not covered
+			iSite = block.primaryStart;
+		}
+		if (iSite > end) {
+			break;
+		}
+		loadRecord_(block);
+		loadSequences_();
+		const uint64_t lastSite = (end < primaryEnd_ ? end : primaryEnd_);
+		scanRecord_(chromosome, iSite, lastSite, sites, length);
+		iSite = lastSite + 1;
+	}
+}
+
+void ParseAXT::buildSiteBits_(const uint32_t &chromosome){
+	const vector<AXTblock> &chrBlocks = (*blocks_)[chromosome];
+	uint64_t chrLength = 0;
+	for (auto &b : chrBlocks) {
+		chrLength = std::max(chrLength, b.primaryEnd);
+	}
+	RankBitVector callable(chrLength);
+	RankBitVector diverged(chrLength);
+	for (auto &b : chrBlocks) {
+		loadRecord_(b);
+		loadSequences_();
+		size_t firstCol;
+		const size_t nColumns = classifyColumns_(chromosome, primaryStart_, primaryEnd_, firstCol);
+		const size_t nWords   = (nColumns + 63)/64;
+		const uint64_t *match = masks_.data() + 3*nWords;
+		const uint64_t *upper = match + nWords;
+		walkColumns_(primaryStart_, nColumns, [&](const size_t &iWord, const uint64_t &nucleotide, const uint64_t &good, const uint64_t &wordSite){
+			uint64_t remaining = good;
+			while (remaining) {
+				const unsigned bit   = static_cast<unsigned>( __builtin_ctzll(remaining) );
+				const uint64_t below = (static_cast<uint64_t>(1) << bit) - 1;
+				const uint64_t iBit  = wordSite + static_cast<uint64_t>( __builtin_popcountll(nucleotide & below) ) - 1;
+				callable.set(iBit);
+				if ( ( (upper[iWord] & ~match[iWord]) >> bit ) & 1 ) { // divergent, with both nucleotides in upper case
+					diverged.set(iBit);
+				}
+				remaining &= remaining - 1;
+			}
+		});
+	}
+	callable.buildRank();
+	diverged.buildRank();
+	callableSites_[chromosome] = std::make_shared<const RankBitVector>( std::move(callable) );
+	divergedSites_[chromosome] = std::make_shared<const RankBitVector>( std::move(diverged) );
+}
+
+void ParseAXT::getSiteStates_(const uint32_t &chromosome, const uint64_t &position, char &primaryState, char &alignedState, uint16_t &sameChromosome){
+	// positions not covered by a record (including positions that fall into a gap between alignment chunks) return values that will be filtered downstream
+	primaryState   = '-';
+	alignedState   = '-';
+	sameChromosome = 0;
+	size_t blockIdx;
+	if ( !findBlock_(chromosome, position, blockIdx) ) {
+		return;
+	}
+	const vector<AXTblock> &chrBlocks = (*blocks_)[chromosome];
+	if ( (blockIdx == chrBlocks.size()) || (position < chrBlocks[blockIdx].primaryStart) ) {
+		return;
+	}
+	loadRecord_(chrBlocks[blockIdx]);
+	loadSequences_();
+	const size_t iCol = column_(position);
+	if (iCol < seqLength_) {   // string length equality already checked in readSequences_()
+		primaryState   = primaryNucleotide_(iCol);
+		alignedState   = alignedNucleotide_(iCol);   // may be a gap, that can be checked in post-processing
+		sameChromosome = sameChr_;
+		return;
+	}
+	stringstream wrongThing;
+	wrongThing << "The record covering positition ";
+	wrongThing << position;
+	wrongThing << " on chromosome ";
+	wrongThing << genome_.name(chromosome);
+	wrongThing << " has fewer nucleotides than its header implies";
+	throw wrongThing.str();
+}
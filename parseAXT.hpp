@@ -30,42 +30,91 @@
 #ifndef parseAXT_hpp
 #define parseAXT_hpp
 
-#include <fstream>
 #include <string>
 #include <vector>
-#include <unordered_map>
+#include <functional>
+#include <memory>
+
+#include "mappedFile.hpp"
+#include "genomeDictionary.hpp"
+#include "outgroupStates.hpp"
+#include "packedAlignment.hpp"
+#include "rankBitVector.hpp"
+#include "siteRecords.hpp"
 
-using std::fstream;
 using std::string;
 using std::vector;
-using std::unordered_map;
+using std::shared_ptr;
 
 namespace BayesicSpace {
 
+	/** \brief Location of an .axt record
+	 *
+	 * Primary genome range covered by an alignment record and the offset of its header line in the file.
+	 */
+	struct AXTblock {
+		/// Primary start position
+		uint64_t primaryStart;
+		/// Primary end position
+		uint64_t primaryEnd;
+		/// Byte offset of the record header
+		size_t offset;
+	};
+
+	/** \brief A run of .axt records
+	 *
+	 * Consecutive records of one chromosome, processed as one task by parallel scans. The position range extends to the start of the next run, so the runs of a chromosome cover it without gaps or overlaps.
+	 */
+	struct AXTchunk {
+		/// Chromosome ID
+		uint32_t chromosome;
+		/// Index of the first record in the chromosome's record list
+		size_t firstBlock;
+		/// One past the index of the last record
+		size_t lastBlock;
+		/// First position
+		uint64_t start;
+		/// Last position
+		uint64_t end;
+	};
+
 	/** \brief .axt alignment parsing class
 	 *
 	 * Exatracts features from an .axt alignement file.
+	 * The file is memory-mapped and records are parsed in place: the current record's sequences are views into the mapped file, not copies.
+	 * Records are located through a block index that maps each chromosome to the primary ranges and file offsets of its records, so queries can come in any order.
+	 * The index is read from a sidecar file (the .axt file name with `.axti` appended, written by `saveIndex()`) if one exists and matches the .axt file; otherwise it is built in memory at construction.
+	 * If there is a matching bit-packed copy of the sequences (the .axt file name with `.axtp` appended, written by `savePackedAlignment()`), sequences are read from it instead of the .axt file.
+	 * Site counts over ranges (`countSites()`) come from per-chromosome rank bit vectors of callable and diverged sites, built the first time a chromosome is counted.
+	 * Sequences of a record are only located, checked and gap-indexed when its columns are first needed, so records whose positions are not queried are never read past the header.
+	 * Records are assumed not to overlap in the primary genome.
 	 *
 	 */
 	class ParseAXT {
 		public:
 			/** \brief Default constructor */
-			ParseAXT() : sameChr_{0}, primaryStart_{0}, primaryEnd_{0}, alignedStart_{0}, alignedEnd_{0}, chrID_{""}, primarySeq_{""}, alignSeq_{""}, foundChr_{""} { axtFile_.exceptions(fstream::badbit); };
+			ParseAXT() : blocks_{std::make_shared< const vector< vector<AXTblock> > >()}, packed_{std::make_shared<const PackedAlignment>()}, nextByte_{0}, recordOffset_{0}, sameChr_{0}, primaryStart_{0}, primaryEnd_{0}, alignedStart_{0}, alignedEnd_{0}, chrID_{""}, primarySeq_{nullptr}, alignSeq_{nullptr}, seqLength_{0}, packedRecord_{nullptr}, sequencesLoaded_{false} {};
 			/** \brief File name constructor
 			 *
-			 * Initializes the file stream and loads first AXT record.
+			 * Maps the file into memory, reads or builds the block index, and loads the header of the first AXT record.
 			 *
 			 * \param[in] fileName file name
 			 */
 			ParseAXT(const string &fileName);
 
 			/** \brief Destructor */
-			~ParseAXT(){ if(axtFile_.is_open()) axtFile_.close(); };
+			~ParseAXT(){};
 
-			/// Copy constructor
-			ParseAXT(const ParseAXT &in) = delete;
+			/** \brief Copy constructor
+			 *
+			 * Makes an independent reader of the same file: the file is mapped again, and the block index, packed copy and site bit vectors are shared with the original (they are never changed once built), so nothing has to be rebuilt or copied.
+			 * Copies can be used concurrently from different threads.
+			 *
+			 * \param[in] in object to copy
+			 */
+			ParseAXT(const ParseAXT &in);
 			/// Move constructor
-			ParseAXT(ParseAXT &&in) : axtFile_{move(in.axtFile_)}, sameChr_{in.sameChr_}, primaryStart_{in.primaryStart_}, primaryEnd_{in.primaryEnd_}, alignedStart_{in.alignedStart_}, alignedEnd_{in.alignedEnd_}, chrID_{move(in.chrID_)}, primarySeq_{move(in.primarySeq_)}, alignSeq_{move(in.alignSeq_)}, foundChr_{move(in.foundChr_)} {};
+			ParseAXT(ParseAXT &&in) : fileName_{move(in.fileName_)}, axtFile_{std::move(in.axtFile_)}, genome_{std::move(in.genome_)}, blocks_{move(in.blocks_)}, packed_{std::move(in.packed_)}, callableSites_{move(in.callableSites_)}, divergedSites_{move(in.divergedSites_)}, nextByte_{in.nextByte_}, recordOffset_{in.recordOffset_}, sameChr_{in.sameChr_}, primaryStart_{in.primaryStart_}, primaryEnd_{in.primaryEnd_}, alignedStart_{in.alignedStart_}, alignedEnd_{in.alignedEnd_}, chrID_{move(in.chrID_)}, primarySeq_{in.primarySeq_}, alignSeq_{in.alignSeq_}, seqLength_{in.seqLength_}, packedRecord_{in.packedRecord_}, sequencesLoaded_{in.sequencesLoaded_}, runPositions_{move(in.runPositions_)}, runColumns_{move(in.runColumns_)}, masks_{move(in.masks_)} {};
 			/// Copy assignment
 			ParseAXT &operator=(const ParseAXT &in) = delete;
 			/// Move assignment
@@ -82,6 +131,8 @@ namespace BayesicSpace {
 			 * - aligned start
 			 * - aligned end
 			 *
+			 * The chromosome and aligned positions are only available for records read from the .axt file, not from a packed copy.
+			 *
 			 *   \return string with metadata
 			 */
 			string getMetaData();
@@ -89,57 +140,108 @@ namespace BayesicSpace {
 			 *
 			 * \return string with the primary sequence
 			 */
-			string getPrimarySeq() {return primarySeq_; };
+			string getPrimarySeq();
 			/** \brief Get aligned sequence
 			 *
 			 * \return string with the aligned sequence
 			 */
-			string getAlignedSeq() {return alignSeq_; };
+			string getAlignedSeq();
 			/** \brief Get list of divergent sites from a range
 			 *
 			 * Get a list of divergent sites from a range of positions on a chromosome. Sites that are not covered or align to gaps are not counted in computing the overall length.
-			 * The vector of sites is appended by the function, so any existing information will be preserved.
-			 * The site description is in a tab-delimited string with the following fields:
-			 *
-			 * - chromosome name
-			 * - position
-			 * - primary nucleotide
-			 * - aligned nucleotide
-			 * - whether the aligned nucleotide is on the same chromosome
-			 * - whether both nucleotides are in upper case (indicating high quality base calls)
+			 * Any existing contents of the site vector are replaced; the sites of the range are then added in position order as they are found.
 			 *
 			 * _NOTE_: The range must be confined to a single chromosome.
 			 *
-			 * \param[in] chromName chromosome name
+			 * \param[in] chromosome chromosome ID
 			 * \param[in] start start position of the target range
 			 * \param[in] end end position of the target range
-			 * \param[out] sites vector of divergent site information (appended after execution)
+			 * \param[out] sites divergent sites in the range, in position order
 			 * \param[out] length length not counting sites that are missing or align to gaps
 			 *
 			 */
-			void getDivergedSites(const string &chromName, const uint64_t &start, const uint64_t &end, vector<string> &sites, uint64_t &length);
+			void getDivergedSites(const uint32_t &chromosome, const uint64_t &start, const uint64_t &end, vector<DivergedSite> &sites, uint64_t &length);
 			/** \brief Get list of divergent sites from a vector of positions
 			 *
-			 * Get a list of divergent sites from a vector of positions. The provided vector of cromosome names must be the same length as the vector of genome positions.
-			 * The chromosome names must be arranged in contiguous blocks, with the same order as in the target .axt file. This is to speed up file traversal.
+			 * Get a list of divergent sites from a vector of positions. The provided vector of cromosome IDs must be the same length as the vector of genome positions.
+			 * Positions can be in any order.
 			 * Sites that are not covered or align to gaps are not counted in computing the overall length.
-			 * The vector of sites is appended by the function, so any existing information will be preserved.
-			 * The site description is in a tab-delimited string with the following fields:
+			 * Each divergent site is passed to the sink as soon as it is found, so results are never held in memory.
 			 *
-			 * - chromosome name
-			 * - position
-			 * - primary nucleotide
-			 * - aligned nucleotide
-			 * - whether the aligned nucleotide is on the same chromosome
-			 * - whether both nucleotides are in upper case (indicating high quality base calls)
+			 * \param[in] chromosomes vector of chromosome IDs
+			 * \param[in] positions vector of query site genome positions
+			 * \param[in,out] sites sink that receives the divergent sites
+			 * \param[out] lengths lengths, indexed by chromosome ID, not counting sites that are missing or align to gaps
 			 *
-			 * \param[in] chromNames vector of chromosome names
+			 */
+			void getDivergedSites(const vector<uint32_t> &chromosomes, const vector<uint64_t> &positions, DivergedSiteSink &sites, vector<uint64_t> &lengths);
+			/** \brief Get list of divergent sites from a vector of positions in parallel
+			 *
+			 * Multi-threaded version of the positions overload. The chromosomes are split into runs of records of about equal size in bytes (see `AXTchunk`), several per thread, so that even a single chromosome is shared between threads.
+			 * Each worker thread has its own copy of the reader and takes the next unprocessed run as soon as it is done with the previous one, visiting the run's query positions in genome order.
+			 * The divergent sites are kept until all runs are done, and then passed to the sink in the order of the input positions; lengths are summed over the runs of each chromosome. The results are the same as with one thread.
+			 *
+			 * \param[in] chromosomes vector of chromosome IDs
 			 * \param[in] positions vector of query site genome positions
-			 * \param[out] sites vector of divergent site information (appended after execution)
-			 * \param[out] lengths lengths, one per chromosome, not counting sites that are missing or align to gaps
+			 * \param[in,out] sites sink that receives the divergent sites
+			 * \param[out] lengths lengths, indexed by chromosome ID, not counting sites that are missing or align to gaps
+			 * \param[in] nThreads number of worker threads
+			 *
+			 */
+			void getDivergedSites(const vector<uint32_t> &chromosomes, const vector<uint64_t> &positions, DivergedSiteSink &sites, vector<uint64_t> &lengths, const size_t &nThreads);
+			/** \brief Get divergent sites from many ranges
+			 *
+			 * Sweeps each chromosome once for all ranges: ranges are sorted by start, and the open ones are kept in a min-heap by end.
+			 * The chromosome is scanned in segments where the set of open ranges does not change, so overlapping stretches are read only once, and each segment's sites are credited to every open range.
+			 * Sites are passed to the sink as they are found, in genome order (chromosome ID, then position); a site in several ranges is passed once for each, in the order of the input ranges.
+			 * Long segments are scanned in pieces, so memory use does not grow with range lengths.
+			 * Ranges can be in any order and can overlap. A range can be a single position (the same start and end).
+			 * Range lengths are not computed; use `countSites()`.
+			 *
+			 * \param[in] chromosomes chromosome ID of each range
+			 * \param[in] starts start position of each range
+			 * \param[in] ends end position of each range
+			 * \param[in,out] sites sink for divergent sites, each with the index of its range
+			 *
+			 */
+			void getDivergedSites(const vector<uint32_t> &chromosomes, const vector<uint64_t> &starts, const vector<uint64_t> &ends, DivergedSiteSink &sites);
+			/** \brief Get divergent sites from many ranges in parallel
+			 *
+			 * Multi-threaded version of the ranges overload. The chromosomes are split into runs of records as in the multi-threaded positions overload, and each worker thread sweeps the ranges of a run, clipped to the run, with its own copy of the reader.
+			 * A run's sites are passed to the sink once all preceding runs are done, so the sink sees the same sequence as with one thread.
+			 *
+			 * \param[in] chromosomes chromosome ID of each range
+			 * \param[in] starts start position of each range
+			 * \param[in] ends end position of each range
+			 * \param[in,out] sites sink for divergent sites, each with the index of its range
+			 * \param[in] nThreads number of worker threads
 			 *
 			 */
-			void getDivergedSites(const vector<string> &chromNames, const vector<uint64_t> &positions, vector<string> &sites, unordered_map<string, uint64_t> &lengths);
+			void getDivergedSites(const vector<uint32_t> &chromosomes, const vector<uint64_t> &starts, const vector<uint64_t> &ends, DivergedSiteSink &sites, const size_t &nThreads);
+			/** \brief Count sites in a range
+			 *
+			 * Counts sites that are covered and do not align to gaps or unknown nucleotides (the `length` of `getDivergedSites()`), and the good quality (both nucleotides in upper case) divergent sites among them, without listing the sites.
+			 * Each count is the difference of two rank queries on the chromosome's site bit vectors, so it does not depend on the length of the range.
+			 * The bit vectors are built by scanning the whole chromosome the first time it is counted.
+			 *
+			 * \param[in] chromosome chromosome ID
+			 * \param[in] start first position of the range
+			 * \param[in] end last position of the range
+			 * \param[out] length number of covered sites that are not missing and do not align to gaps
+			 * \param[out] nDiverged number of good quality divergent sites
+			 */
+			void countSites(const uint32_t &chromosome, const uint64_t &start, const uint64_t &end, uint64_t &length, uint64_t &nDiverged);
+			/** \brief Count sites in many ranges
+			 *
+			 * Vector version of `countSites()`. Ranges can be in any order and can overlap.
+			 *
+			 * \param[in] chromosomes chromosome ID of each range
+			 * \param[in] starts start position of each range
+			 * \param[in] ends end position of each range
+			 * \param[out] lengths number of covered sites that are not missing and do not align to gaps in each range
+			 * \param[out] nDiverged number of good quality divergent sites in each range
+			 */
+			void countSites(const vector<uint32_t> &chromosomes, const vector<uint64_t> &starts, const vector<uint64_t> &ends, vector<uint64_t> &lengths, vector<uint64_t> &nDiverged);
 			/** \brief Get the outgroup state for a position
 			 *
 			 * The aligned genome is assumed to belong to the outgroup species. The site description is in a three-letter (no delimitation) string with the following fields:
@@ -148,15 +250,117 @@ namespace BayesicSpace {
 			 * - whether the aligned nucleotide is on the same chromosome
 			 * - whether the aligned nucleotide is in upper case (indicating high quality base calls)
 			 *
-			 * \param[in] chromName chromosome name
+			 * \param[in] chromosome chromosome ID
 			 * \param[in] position query site genome position
 			 * \param[out] site outgroup site information
 			 *
 			 */
-			void getOutgroupState(const string &chromName, const uint64_t &position, string &site);
+			void getOutgroupState(const uint32_t &chromosome, const uint64_t &position, string &site);
+			/** \brief Get the encoded outgroup state for a position
+			 *
+			 * The same information as `getOutgroupState()`, packed into one byte (see `OutgroupStates`).
+			 *
+			 * \param[in] chromosome chromosome ID
+			 * \param[in] position query site genome position
+			 * \return outgroup state byte
+			 */
+			uint8_t getOutgroupState(const uint32_t &chromosome, const uint64_t &position);
+			/** \brief Save the block index
+			 *
+			 * Writes the block index to a tab-delimited text file. The first line is `#AXTI` followed by the size of the .axt file in bytes and its modification time in nanoseconds, used to detect stale indexes.
+			 * Each following line describes one record: chromosome name, primary start, primary end, and the byte offset of the record header.
+			 * The index is picked up by the constructor if saved to the .axt file name with `.axti` appended.
+			 *
+			 * \param[in] indexFileName index file name
+			 */
+			void saveIndex(const string &indexFileName);
+			/** \brief Save the outgroup state table
+			 *
+			 * Projects the alignment onto primary genome coordinates and writes the outgroup state of every position, one byte per position, in the format read by `OutgroupStates`.
+			 * The table is picked up by `ParseVCF` if saved to the .axt file name with `.anc` appended.
+			 *
+			 * \param[in] stateFileName outgroup state file name
+			 */
+			void saveOutgroupStates(const string &stateFileName){ saveOutgroupStates(stateFileName, 1); };
+			/** \brief Save the outgroup state table using several threads
+			 *
+			 * Each chromosome's table is filled by several threads, each projecting a run of records (see `AXTchunk`) with its own copy of the reader. The file is the same as with one thread.
+			 *
+			 * \param[in] stateFileName outgroup state file name
+			 * \param[in] nThreads number of threads
+			 */
+			void saveOutgroupStates(const string &stateFileName, const size_t &nThreads);
+			/** \brief Pack the alignment
+			 *
+			 * Builds a bit-packed copy of all record sequences in memory (see `PackedAlignment`). Scans then classify alignment columns with word-level bit operations on the packed copy.
+			 * Does nothing if the sequences are already packed.
+			 * Throws if a sequence has a character other than A, C, G, T, N or a gap in either case (e.g., an IUPAC ambiguity code such as R); the alignment is then left unpacked.
+			 */
+			void packAlignment();
+			/** \brief Save the packed alignment
+			 *
+			 * Packs the alignment if it is not yet packed and saves the packed copy. The copy is picked up by the constructor if saved to the .axt file name with `.axtp` appended.
+			 *
+			 * \param[in] packedFileName packed alignment file name
+			 */
+			void savePackedAlignment(const string &packedFileName);
+			/** \brief Chromosome ID
+			 *
+			 * Looks up the canonical form of a chromosome name (see `GenomeDictionary::canonicalName()`).
+			 *
+			 * \param[in] chromName chromosome name
+			 * \return chromosome ID; `GenomeDictionary::missing` if the chromosome is not in the alignment
+			 */
+			uint32_t chromosomeID(const string &chromName) const { return genome_.find( GenomeDictionary::canonicalName(chromName) ); };
+			/** \brief Chromosome name
+			 *
+			 * \param[in] chromosome chromosome ID
+			 * \return chromosome name
+			 */
+			const string &chromosomeName(const uint32_t &chromosome) const { return genome_.name(chromosome); };
+			/** \brief Chromosome names
+			 *
+			 * \return chromosome names, indexed by chromosome ID
+			 */
+			const vector<string> &chromosomeNames() const { return genome_.names(); };
+			/** \brief Chromosome dictionary
+			 *
+			 * Chromosomes are added in the order of first appearance in the file.
+			 *
+			 * \return the dictionary
+			 */
+			const GenomeDictionary &genome() const { return genome_; };
 		private:
-			/// The file stream
-			fstream axtFile_;
+			/// Longest stretch scanned at once by the ranges sweep (1 Mb)
+			static const uint64_t sweepPiece_ = 1048576;
+			/// The .axt file name
+			string fileName_;
+			/// The memory-mapped file
+			MappedFile axtFile_;
+			/// Chromosome IDs, in the order of first appearance in the file
+			GenomeDictionary genome_;
+			/** \brief Block index
+			 *
+			 * Records of each chromosome (indexed by ID), in order of primary start position. Not changed once built, so copies of the reader share it.
+			 */
+			shared_ptr< const vector< vector<AXTblock> > > blocks_;
+			/// Bit-packed copy of the sequences (empty if sequences are read from the .axt file); shared by copies of the reader
+			shared_ptr<const PackedAlignment> packed_;
+			/** \brief Callable sites
+			 *
+			 * One rank bit vector per chromosome (indexed by ID), with a bit set for each position (bit `position - 1`) that is covered and does not align to a gap or unknown nucleotide. `nullptr` until the chromosome is first counted.
+			 * The vectors are not changed once built, so copies of the reader share them.
+			 */
+			vector< shared_ptr<const RankBitVector> > callableSites_;
+			/** \brief Good quality divergent sites
+			 *
+			 * Laid out like `callableSites_`, with bits set for divergent sites where both nucleotides are in upper case.
+			 */
+			vector< shared_ptr<const RankBitVector> > divergedSites_;
+			/// Offset of the first byte after the part of the current record read so far
+			size_t nextByte_;
+			/// Offset of the current record header
+			size_t recordOffset_;
 
 			// variables for the current record
 			/// Is the aligned chromosome the same (1 for yes, 0 for no)?
@@ -171,26 +375,241 @@ namespace BayesicSpace {
 			uint64_t alignedEnd_;
 			/// Primary chromosome
 			string chrID_;
-			/// Current record's primary sequence
-			string primarySeq_;
-			/// Current record's aligning sequence
-			string alignSeq_;
-			/// Last completely examined chromosome
-			string foundChr_;
-			/** \brief Get next record */
-			void getNextRecord_();
+			/// Current record's primary sequence (points into the mapped file)
+			const char *primarySeq_;
+			/// Current record's aligning sequence (points into the mapped file)
+			const char *alignSeq_;
+			/// Length of both sequences in the current record
+			size_t seqLength_;
+			/// Current record in the packed copy (`nullptr` if the record was read from the .axt file)
+			const PackedRecord *packedRecord_;
+			/// Have the sequences of the current record been located and gap-indexed?
+			bool sequencesLoaded_;
+			/** \brief Gap-free run start positions
+			 *
+			 * Genome position of the first nucleotide in each run of non-gap primary sequence columns of the current record. The last element is one past the last covered position.
+			 */
+			vector<uint64_t> runPositions_;
+			/** \brief Gap-free run start columns
+			 *
+			 * Alignment column (offset from `primarySeq_`) of the first nucleotide in each run listed in `runPositions_`.
+			 */
+			vector<size_t> runColumns_;
+			/** \brief Column classification masks
+			 *
+			 * Scratch space for `alignmentMasks()`, reused between ranges.
+			 */
+			vector<uint64_t> masks_;
+			/** \brief Read the next record header
+			 *
+			 * Skips empty and comment lines starting at `nextByte_`, then parses the header in place. `nextByte_` is left at the start of the primary sequence.
+			 *
+			 * \return `false` if there are no more records in the file
+			 */
+			bool readHeader_();
+			/** \brief Read record sequences
+			 *
+			 * Points `primarySeq_` and `alignSeq_` to the two sequence lines that start at `nextByte_` and checks that they are the same length.
+			 */
+			void readSequences_();
+			/** \brief Skip record sequences
+			 *
+			 * Moves `nextByte_` past the two sequence lines that start at `nextByte_` without reading them in full.
+			 * The primary line has at least one character per position in the header range, so the search for its end starts past those, and the end of the aligned line is checked directly at the same length.
+			 * Sequence contents are checked when the record is loaded; if the line ends do not fall where expected, the lines are read in full to report the problem.
+			 */
+			void skipSequences_();
+			/** \brief Build the block index
+			 *
+			 * Scans the whole file, recording the location of each record.
+			 */
+			void buildIndex_();
+			/** \brief Load the block index
+			 *
+			 * Reads an index saved by `saveIndex()`.
+			 *
+			 * \param[in] indexFileName index file name
+			 * \return `false` if the index does not match the .axt file
+			 */
+			bool loadIndex_(const string &indexFileName);
+			/** \brief Add a record to the block index
+			 *
+			 * Checks that records on the same chromosome are in order of increasing primary start position.
+			 *
+			 * \param[in] chromosome chromosome name
+			 * \param[in] block record location
+			 * \param[in,out] blocks block index being built
+			 */
+			void addBlock_(const string &chromosome, const AXTblock &block, vector< vector<AXTblock> > &blocks);
+			/** \brief Find the first record relevant to a position
+			 *
+			 * \param[in] chromosome chromosome ID
+			 * \param[in] position site position in the primary sequence
+			 * \param[out] blockIdx index of the first record of the chromosome that ends at or after `position`; equal to the number of chromosome records if there is none
+			 * \return `false` if the chromosome is not in the file
+			 */
+			bool findBlock_(const uint32_t &chromosome, const uint64_t &position, size_t &blockIdx) const;
+			/** \brief Make a record current
+			 *
+			 * Reads the record header unless the record is already current. The sequences are not read until `loadSequences_()` is called.
+			 *
+			 * \param[in] block record location
+			 */
+			void loadRecord_(const AXTblock &block);
+			/** \brief Load the sequences of the current record
+			 *
+			 * Locates the sequences of the record made current by `loadRecord_()` (in the .axt file or the packed copy) and indexes their gaps, unless this is already done.
+			 */
+			void loadSequences_();
+			/** \brief Get next line
+			 *
+			 * Finds the line that starts at `nextByte_` and moves `nextByte_` past its end.
+			 *
+			 * \param[out] lineStart pointer to the first character of the line
+			 * \param[out] lineEnd pointer to one past the last character of the line (excluding the newline)
+			 * \return `false` if there are no more lines in the file
+			 */
+			bool getNextLine_(const char *&lineStart, const char *&lineEnd);
+			/** \brief Index primary sequence gaps
+			 *
+			 * Builds the gap-free run index (`runPositions_` and `runColumns_`) for the current record.
+			 */
+			void indexGaps_();
+			/** \brief Primary nucleotide of the current record
+			 *
+			 * \param[in] iCol alignment column
+			 * \return the nucleotide
+			 */
+			char primaryNucleotide_(const size_t &iCol) const { return (packedRecord_ != nullptr) ? packed_->primary(*packedRecord_, iCol) : primarySeq_[iCol]; };
+			/** \brief Aligned nucleotide of the current record
+			 *
+			 * \param[in] iCol alignment column
+			 * \return the nucleotide
+			 */
+			char alignedNucleotide_(const size_t &iCol) const { return (packedRecord_ != nullptr) ? packed_->aligned(*packedRecord_, iCol) : alignSeq_[iCol]; };
+			/** \brief Find the alignment column of a position
+			 *
+			 * Binary search of the gap-free run index. The position must be within the current record.
+			 *
+			 * \param[in] position site position in the primary sequence
+			 * \return alignment column index; `seqLength_` if the position is past the last nucleotide in the record
+			 */
+			size_t column_(const uint64_t &position) const;
+			/** \brief Scan a range of positions in the current record
+			 *
+			 * Classifies the alignment columns of the current record with the vectorized `alignmentMasks()` kernel, appending divergent sites and counting sites that are not missing and do not align to gaps.
+			 * The range must be within the current record.
+			 *
+			 * \param[in] chromosome chromosome index
+			 * \param[in] from first position of the range
+			 * \param[in] to last position of the range
+			 * \param[in,out] sites vector of divergent site information; sites are added after any existing contents, in position order, as they are found
+			 * \param[in,out] length length not counting sites that are missing or align to gaps; incremented by the length of the range
+			 *
+			 */
+			void scanRecord_(const uint32_t &chromosome, const uint64_t &from, const uint64_t &to, vector<DivergedSite> &sites, uint64_t &length);
+			/** \brief Classify the columns of a range of positions in the current record
+			 *
+			 * Fills `masks_` with the five `alignmentMasks()` planes for the columns from the one at `from` to the one at `to`. The range must be within the current record.
+			 *
+			 * \param[in] chromosome chromosome index (for error messages)
+			 * \param[in] from first position of the range
+			 * \param[in] to last position of the range
+			 * \param[out] firstCol alignment column of `from`
+			 * \return number of classified columns
+			 */
+			size_t classifyColumns_(const uint32_t &chromosome, const uint64_t &from, const uint64_t &to, size_t &firstCol);
+			/** \brief Walk classified columns a word at a time
+			 *
+			 * Goes through the columns classified by `classifyColumns_()` in 64-column words. For each word, passes to `visit` the word index, the mask of columns with a primary nucleotide, the mask of those columns that do not align to gaps or unknown nucleotides, and the position of the first primary nucleotide in the word.
+			 *
+			 * \param[in] from position of the first classified column
+			 * \param[in] nColumns number of classified columns
+			 * \param[in] visit function called for each word
+			 */
+			void walkColumns_(const uint64_t &from, const size_t &nColumns, const std::function<void(const size_t &, const uint64_t &, const uint64_t &, const uint64_t &)> &visit) const;
+			/** \brief Build the site bit vectors of a chromosome
+			 *
+			 * Scans every record of the chromosome and fills its `callableSites_` and `divergedSites_` elements.
+			 *
+			 * \param[in] chromosome chromosome ID
+			 */
+			void buildSiteBits_(const uint32_t &chromosome);
+			/** \brief Sweep many ranges
+			 *
+			 * Implements the ranges overload of `getDivergedSites()`, passing each site and range index to a callback.
+			 *
+			 * \param[in] chromosomes chromosome ID of each range
+			 * \param[in] starts start position of each range
+			 * \param[in] ends end position of each range
+			 * \param[in] found called with each divergent site and the index of a range that contains it
+			 */
+			void sweepRanges_(const vector<uint32_t> &chromosomes, const vector<uint64_t> &starts, const vector<uint64_t> &ends, const std::function<void(const DivergedSite &, const size_t &)> &found);
+			/** \brief Scan a range of positions
+			 *
+			 * Scans all records that overlap the range.
+			 *
+			 * \param[in] chromosome chromosome ID
+			 * \param[in] start first position of the range
+			 * \param[in] end last position of the range
+			 * \param[in,out] sites vector of divergent site information; sites are added after any existing contents, in position order, as they are found
+			 * \param[in,out] length length not counting sites that are missing or align to gaps; incremented by the length of the range
+			 */
+			void scanRange_(const uint32_t &chromosome, const uint64_t &start, const uint64_t &end, vector<DivergedSite> &sites, uint64_t &length);
 			/** \brief Extracts the nucleotides at a given position
 			 *
 			 * The query position references the primary sequence
 			 *
-			 * \param[in] chromosome primary chromosome
+			 * \param[in] chromosome primary chromosome ID
 			 * \param[in] position site position in the primary sequence
 			 * \param[out] primaryState the primary nucleotide at the query position
 			 * \param[out] alignedState the aligned nucleotide at the query position
 			 * \param[out] sameChromosome is the aligned sequence on the same chromosome as primary? (0: no, 1: yes)
 			 *
 			 */
-			void getSiteStates_(const string &chromosome, const uint64_t &position, char &primaryState, char &alignedState, uint16_t &sameChromosome);
+			void getSiteStates_(const uint32_t &chromosome, const uint64_t &position, char &primaryState, char &alignedState, uint16_t &sameChromosome);
+			/** \brief Classify a query position
+			 *
+			 * \param[in] chromosome chromosome ID
+			 * \param[in] position site position in the primary sequence
+			 * \param[out] site site information; only meaningful if the site is divergent
+			 * \param[out] diverged is the site divergent?
+			 * \return `true` if the site is covered and does not align to a gap or unknown nucleotide
+			 */
+			bool checkSite_(const uint32_t &chromosome, const uint64_t &position, DivergedSite &site, bool &diverged);
+			/** \brief Split chromosomes into runs of records
+			 *
+			 * The records of each listed chromosome are split into runs of consecutive records of about equal size in bytes, with several runs per thread.
+			 *
+			 * \param[in] chromosomes IDs of the chromosomes to split, in any order and possibly repeated; IDs not in the alignment are ignored
+			 * \param[in] nThreads number of worker threads
+			 * \param[out] chunks record runs, in chromosome ID and position order
+			 */
+			void makeChunks_(const vector<uint32_t> &chromosomes, const size_t &nThreads, vector<AXTchunk> &chunks) const;
+			/** \brief Find the record run that contains a position
+			 *
+			 * \param[in] chunks record runs made by `makeChunks_()`
+			 * \param[in] chromosome chromosome ID
+			 * \param[in] position site position in the primary sequence
+			 * \return index of the run; the number of runs if the chromosome was not split
+			 */
+			size_t findChunk_(const vector<AXTchunk> &chunks, const uint32_t &chromosome, const uint64_t &position) const;
+			/** \brief Run tasks in parallel
+			 *
+			 * Each worker thread makes its own copy of the reader and takes the next unstarted task until all are done. The first error thrown by a task is re-thrown after all threads finish.
+			 *
+			 * \param[in] nTasks number of tasks
+			 * \param[in] nThreads number of worker threads
+			 * \param[in] process function that runs one task (by index) with a worker's reader
+			 */
+			void runTasks_(const size_t &nTasks, const size_t &nThreads, const std::function<void(ParseAXT &, const size_t &)> &process) const;
+			/** \brief Project a record onto the outgroup state table
+			 *
+			 * \param[in] chromosome chromosome ID
+			 * \param[in] block record location
+			 * \param[in,out] states outgroup states of the chromosome, indexed by position - 1
+			 */
+			void projectRecord_(const uint32_t &chromosome, const AXTblock &block, vector<uint8_t> &states);
 	};
 }
 #endif /* parseAXT_hpp */
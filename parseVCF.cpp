@@ -31,11 +31,26 @@
 #include <vector>
 #include <sstream>
 #include <cstdlib>
+#include <cstring>
 #include <cctype>
 #include <system_error>
+#include <algorithm>
+#include <utility>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 
 #include "parseVCF.hpp"
 #include "parseAXT.hpp"
+#include "outgroupStates.hpp"
+#include "mappedFile.hpp"
+#include "bgzfFile.hpp"
+#include "tabixIndex.hpp"
+#include "simdKernels.hpp"
+#include "utilities.hpp"
 
 using std::fstream;
 using std::ofstream;
@@ -44,25 +59,179 @@ using std::string;
 using std::vector;
 using std::system_error;
 using std::ios;
+using std::pair;
+using std::deque;
+using std::map;
+using std::thread;
+using std::mutex;
+using std::unique_lock;
+using std::lock_guard;
+using std::condition_variable;
+using std::move;
 
 using namespace BayesicSpace;
 
+const size_t VCFrecord::nFixedFields_;
+const size_t ParseVCF::chunkSize_;
 
-ParseVCF::ParseVCF(const string &vcfFileName, const string &axtFileName) : varPos_{0}, refID_{'\0'}, altID_{'\0'}, ancState_{'u'}, outQual_{0}, sameChr_{0}, numMissing_{0}, numCalled_{0}, refAC_{0}, refMLAC_{0}, refAF_{0.0}, refMLAF_{0.0}, quality_{0.0}, chrID_{""}, completeChr_{""}, fullRecord_{""} {
+
+void VCFrecord::tokenize(const char *line, const size_t &lineLength, const GenomeDictionary &genome){
+	line_       = line;
+	lineLength_ = lineLength;
+	const char *lineEnd = line + lineLength;
+	const char *field   = line;
+	size_t iField       = 0;
+	fieldStart_[0]      = 0;
+	while (iField < nFixedFields_) {
+		const char *tab = static_cast<const char*>( memchr(field, '\t', static_cast<size_t>(lineEnd - field)) );
+		if (tab == nullptr) {
+			break;
+		}
+		field                 = tab + 1;
+		fieldStart_[++iField] = static_cast<size_t>(field - line);
+	}
+	if (iField < 7) {
+		string error = "ERROR: VCF record " + string( line, (lineLength < 50 ? lineLength : 50) ) + " has fewer than eight tab-delimited fields";
+		throw error;
+	}
+	for (size_t iMissing = iField + 1; iMissing <= nFixedFields_; iMissing++) { // absent fields start past the end of the line, so that all have a consistent length
+		fieldStart_[iMissing] = lineLength + 1;
+	}
+	// the name is only looked up when it changes or the dictionary grows
+	const size_t chrLength = fieldStart_[1] - 1;
+	if ( (chrName_.compare(0, string::npos, line, chrLength) != 0) || ( genomeSize_ != genome.size() ) ) {
+		chrName_.assign(line, chrLength);
+		chromosome_ = genome.find( GenomeDictionary::canonicalName(line, chrLength) );
+		genomeSize_ = genome.size();
+	}
+	parseUnsigned(line + fieldStart_[1], line + fieldStart_[2], varPos_);
+}
+
+void VCFrecord::parse(const uint8_t &outgroup){
+	refID_   = line_[ fieldStart_[3] ];
+	altID_   = line_[ fieldStart_[4] ];
+	quality_ = strtod(line_ + fieldStart_[5], NULL);
+
+	// count missing data in the sample columns
+	numMissing_ = 0;
+	if (fieldStart_[nFixedFields_] < lineLength_) {
+		numMissing_ = countMissingGenotypes(line_ + fieldStart_[nFixedFields_], lineLength_ - fieldStart_[nFixedFields_]);
+	}
+	// parse the INFO field; keys that are absent are reported as 0, not carried over from the previous record
+	refAC_     = 0;
+	refAF_     = 0.0;
+	numCalled_ = 0;
+	refMLAC_   = 0;
+	refMLAF_   = 0.0;
+	const char *info    = line_ + fieldStart_[7];
+	const char *infoEnd = line_ + fieldStart_[8] - 1;
+	while (info < infoEnd) {
+		const char *infoFieldEnd = static_cast<const char*>( memchr(info, ';', static_cast<size_t>(infoEnd - info)) );
+		if (infoFieldEnd == nullptr) {
+			infoFieldEnd = infoEnd;
+		}
+		const size_t infoLength = static_cast<size_t>(infoFieldEnd - info);
+		uint64_t count = 0;
+		if ( (infoLength > 3) && (strncmp(info, "AC=", 3) == 0) ) {
+			parseUnsigned(info + 3, infoFieldEnd, count);
+			refAC_ = static_cast<uint32_t>(count);
+		} else if ( (infoLength > 3) && (strncmp(info, "AF=", 3) == 0) ) {
+			refAF_ = strtod(info + 3, NULL);
+		} else if ( (infoLength > 3) && (strncmp(info, "AN=", 3) == 0) ) {
+			parseUnsigned(info + 3, infoFieldEnd, count);
+			numCalled_ = static_cast<uint32_t>(count);
+		} else if ( (infoLength > 6) && (strncmp(info, "MLEAC=", 6) == 0) ) {
+			parseUnsigned(info + 6, infoFieldEnd, count);
+			refMLAC_ = static_cast<uint32_t>(count);
+		} else if ( (infoLength > 6) && (strncmp(info, "MLEAF=", 6) == 0) ) {
+			refMLAF_ = strtod(info + 6, NULL);
+		}
+		info = infoFieldEnd + 1;
+	}
+	// Now find the ancestral state if we can
+	const char outNuc = OutgroupStates::nucleotide(outgroup);
+	if (outNuc == 'N') {
+		ancState_ = 'u';
+		sameChr_  = 0;
+		outQual_  = 0;
+	} else {
+		ancState_ = (outNuc == refID_ ? 'r' : 'a');
+		outQual_  = OutgroupStates::quality(outgroup);
+		sameChr_  = OutgroupStates::sameChromosome(outgroup);
+	}
+}
+
+PolySite VCFrecord::site() const {
+	PolySite site;
+	site.chromosome  = chromosome_;
+	site.position    = varPos_;
+	site.reference   = refID_;
+	site.alternative = altID_;
+	site.ancestral   = ancState_;
+	if (ancState_ == 'a') {
+		site.derivedAC   = numCalled_ - refAC_;
+		site.derivedMLAC = numCalled_ - refMLAC_;
+		site.derivedAF   = 1.0 - refAF_;
+		site.derivedMLAF = 1.0 - refMLAF_;
+	} else {
+		site.derivedAC   = refAC_;
+		site.derivedMLAC = refMLAC_;
+		site.derivedAF   = refAF_;
+		site.derivedMLAF = refMLAF_;
+	}
+	site.numMissing      = numMissing_;
+	site.sameChr         = sameChr_;
+	site.outgroupQuality = outQual_;
+	site.quality         = quality_;
+
+	return site;
+}
+
+ParseVCF::ParseVCF(const string &vcfFileName, const string &axtFileName) : completeChr_{GenomeDictionary::missing}, fullRecord_{""}, vcfFileName_{vcfFileName}, compressed_{false}, recordOffset_{0} {
 	if( vcfFile_.is_open() ){
 		vcfFile_.close();
 	}
 
-	try {
-		vcfFile_.open(vcfFileName.c_str(), ios::in);
-	} catch(system_error &error) {
-		string message = "ERROR: cannot open file " + vcfFileName + " to read: " + error.code().message();
-		throw message;
+	if ( BGZFfile::isBGZF(vcfFileName) ) {
+		compressed_ = true;
+		bgzfFile_   = BGZFfile(vcfFileName);
+		for (auto &extension : {".tbi", ".csi"}) {
+			const string indexFileName = vcfFileName + extension;
+			fstream indexTest(indexFileName.c_str(), ios::in);
+			if ( indexTest.is_open() ) {
+				indexTest.close();
+				index_ = TabixIndex(indexFileName);
+				break;
+			}
+		}
+	} else {
+		try {
+			vcfFile_.open(vcfFileName.c_str(), ios::in);
+		} catch(system_error &error) {
+			string message = "ERROR: cannot open file " + vcfFileName + " to read: " + error.code().message();
+			throw message;
+		}
 	}
 
-	axtObj_ = ParseAXT(axtFileName);
+	// a current outgroup state table saves parsing the alignment
+	const string stateFileName = axtFileName + ".anc";
+	fstream stateTest(stateFileName.c_str(), ios::in);
+	if ( stateTest.is_open() ) {
+		stateTest.close();
+		outgroupStates_ = OutgroupStates(stateFileName);
+		const MappedFile axtFile(axtFileName);
+		if ( ( outgroupStates_.axtSize() != static_cast<uint64_t>( axtFile.size() ) ) || ( outgroupStates_.axtModified() != axtFile.modified() ) ) { // the .axt file changed after the table was saved
+			outgroupStates_ = OutgroupStates();
+		}
+	}
+	if ( outgroupStates_.loaded() ) {
+		genome_ = outgroupStates_.genome(); // chromosomes in the table keep their .axt IDs
+	} else {
+		axtObj_ = ParseAXT(axtFileName);
+		genome_ = axtObj_.genome(); // chromosomes in the alignment keep their IDs, so outgroup lookups need no translation
+	}
 
-	while(getline(vcfFile_, fullRecord_)){
+	while( readLine_() ){
 		if (fullRecord_[0] == '#') {
 			continue;
 		} else if (fullRecord_ == "") {
@@ -74,10 +243,11 @@ ParseVCF::ParseVCF(const string &vcfFileName, const string &axtFileName) : varPo
 	if (fullRecord_ == ""){
 		throw string("No non-empty non-comment lines in file ") + vcfFileName;
 	}
+	tokenizeRecord_();
 
 }
 
-void ParseVCF::getPolySites(const string &chromName, const uint64_t &start, const uint64_t &end, vector<string> &sites){
+void ParseVCF::getPolySites(const uint32_t &chromosome, const uint64_t &start, const uint64_t &end, PolySiteSink &sites){
 	if (start >= end) {
 		stringstream wrongThing;
 		wrongThing << "ERROR: start position (";
@@ -87,209 +257,490 @@ void ParseVCF::getPolySites(const string &chromName, const uint64_t &start, cons
 		wrongThing << ") in getPolySites()";
 		throw wrongThing.str();
 	}
-	if (chromName == completeChr_) {
+	if ( index_.loaded() ) {
+		if ( !seekTo_(chromosome, start, end) ) {
+			return;
+		}
+	} else if (chromosome == completeChr_) {
 		return;
 	}
 	bool foundChrom = false; // keep track if the target chromosome was found in the search; needed to test if we looked though the whole thing without finding our site(s)
 
-	stringstream recSS(fullRecord_);
-	string curChr;
-	recSS >> curChr;
-	if (curChr.size() <= 2){
-		curChr = "chr" + curChr;
-	}
-	// process first record (already loaded at construction and guaranteed non-empty)
-	if (chromName == curChr) {
+	// process the current record (already loaded at construction or by a previous search)
+	if ( chromosome == record_.chromosome() ) {
 		foundChrom = true;
-		string curPosStr;
-		recSS >> curPosStr;
-		uint64_t curPos = strtoul(curPosStr.c_str(), NULL, 0);
-		if ( (curPos >= start) && (curPos <= end) ) {
-			parseCurrentRecord_();
-			sites.push_back( exportCurRecord_() );
-		} else if (curPos > end) { // went past the end; done
+		if ( (record_.position() >= start) && (record_.position() <= end) ) {
+			record_.parse( outgroupState_(axtObj_, record_) );
+			sites.put( record_.site() );
+		} else if (record_.position() > end) { // went past the end; done
 			return;
 		}
-	} else if (foundChrom) {
-		completeChr_ = chromName;
-		foundChrom   = false;
-		return;
 	}
-	while(getline(vcfFile_, fullRecord_)){
-		if (fullRecord_.size() == 0) {
-			continue;
-		}
-		recSS.str(fullRecord_);
-		recSS >> curChr;
-		if (curChr.size() <= 2){
-			curChr = "chr" + curChr;
-		}
-		// process first record (already loaded at construction and guaranteed non-empty)
-		if (chromName == curChr) {
+	while( nextRecord_() ){
+		if ( chromosome == record_.chromosome() ) {
 			foundChrom = true;
-			string curPosStr;
-			recSS >> curPosStr;
-			uint64_t curPos = strtoul(curPosStr.c_str(), NULL, 0);
-			if ( (curPos >= start) && (curPos <= end) ) {
-				parseCurrentRecord_();
-				sites.push_back( exportCurRecord_() );
-			} else if (curPos > end) { // went past the end; done
+			if ( (record_.position() >= start) && (record_.position() <= end) ) {
+				record_.parse( outgroupState_(axtObj_, record_) );
+				sites.put( record_.site() );
+			} else if (record_.position() > end) { // went past the end; done
 				return;
 			}
 		} else if (foundChrom) {
-			completeChr_ = chromName;
+			completeChr_ = chromosome;
 			foundChrom   = false;
 			return;
 		}
 	}
 }
 
-void ParseVCF::getPolySites(const vector<string> &chromNames, const vector<uint64_t> &positions, vector<string> &sites){
-	if (positions.size() != chromNames.size()) {
+void ParseVCF::getPolySites(const vector<uint32_t> &chromosomes, const vector<uint64_t> &positions, PolySiteSink &sites){
+	if ( positions.size() != chromosomes.size() ) {
 		stringstream wrongThing;
-		wrongThing << "ERROR: the vector of chromosome names (size = ";
-		wrongThing << chromNames.size();
+		wrongThing << "ERROR: the vector of chromosome IDs (size = ";
+		wrongThing << chromosomes.size();
 		wrongThing << ") not the same size as the vector of positions (size = ";
 		wrongThing << positions.size();
-		wrongThing << ") in getDivergedSites()";
+		wrongThing << ") in getPolySites()";
 		throw wrongThing.str();
 	}
-	for (size_t i = 0; i < positions.size(); ++i) {
-		if (chromNames[i] == completeChr_) { // if the current chromosome has been completed, keep going (maybe more chromosomes to look at)
-			continue;
-		}
-		bool foundChrom = false;
-		// first exmine already existing fullRecord_ since the previous processes (including the constructor) already pre-loaded it
-		stringstream recSS(fullRecord_);
-		string curChr;
-		recSS >> curChr;
-		if (curChr.size() <= 2){
-			curChr = "chr" + curChr;
-		}
-		if (chromNames[i] == curChr) {
-			foundChrom = true;
-			string curPosStr;
-			recSS >> curPosStr;
-			uint64_t curPos = strtoul(curPosStr.c_str(), NULL, 0);
-			if (curPos == positions[i]) {
-				parseCurrentRecord_();
-				sites.push_back( exportCurRecord_() );
-			} else if (curPos > positions[i]) { // went past the current position; do the next one
+	// rank chromosomes by first appearance among the queries, and sort the queries by (rank, position)
+	vector<size_t> queryRank;
+	vector<size_t> chromRank;
+	rankQueries_(chromosomes, queryRank, chromRank);
+	vector<size_t> order( positions.size() );
+	for (size_t iQuery = 0; iQuery < order.size(); iQuery++) {
+		order[iQuery] = iQuery;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](const size_t &first, const size_t &second){
+		return (queryRank[first] < queryRank[second]) || ( (queryRank[first] == queryRank[second]) && (positions[first] < positions[second]) );
+	});
+
+	// Records on chromosomes without queries cannot match. Without an index they are skipped; with an index they are past the query chromosome, because reading always starts from an indexed offset on it.
+	const size_t unranked = chromRank.size();
+	bool haveRecord       = !fullRecord_.empty();
+	for (auto &iQuery : order) {
+		if ( index_.loaded() ) {
+			if ( !seekTo_(chromosomes[iQuery], positions[iQuery], positions[iQuery]) ) {
 				continue;
 			}
-		} else if (foundChrom) {
-			completeChr_  = chromNames[i]; // we are on a new chromosome, past the previous one
-			foundChrom = false;
-			continue;
+			haveRecord = true;
+		} else if (!haveRecord) { // the file is exhausted
+			break;
 		}
-		while(getline(vcfFile_, fullRecord_)){
-			if (fullRecord_.size() == 0) {
-				continue;
-			}
-			if (chromNames[i] == completeChr_) {
+		// advance the records until the current one is not before the query
+		while (haveRecord) {
+			const size_t rank = ( record_.chromosome() < chromRank.size() ? chromRank[record_.chromosome()] : unranked );
+			if ( ( (rank != unranked) || index_.loaded() ) && ( (rank > queryRank[iQuery]) || ( (rank == queryRank[iQuery]) && (record_.position() >= positions[iQuery]) ) ) ) {
 				break;
 			}
-			recSS.str(fullRecord_);
-			recSS >> curChr;
-			if (curChr.size() <= 2){
-				curChr = "chr" + curChr;
-			}
-			if (chromNames[i] == curChr) {
-				foundChrom = true;
-				string curPosStr;
-				recSS >> curPosStr;
-				uint64_t curPos = strtoul(curPosStr.c_str(), NULL, 0);
-				if (curPos == positions[i]) {
-					parseCurrentRecord_();
-					sites.push_back( exportCurRecord_() );
+			haveRecord = nextRecord_();
+		}
+		if ( haveRecord && (record_.chromosome() == chromosomes[iQuery]) && (record_.position() == positions[iQuery]) ) {
+			record_.parse( outgroupState_(axtObj_, record_) );
+			sites.put( record_.site() );
+		}
+	}
+}
+
+void ParseVCF::getPolySites(const vector<uint32_t> &chromosomes, const vector<uint64_t> &starts, const vector<uint64_t> &ends, PolySiteSink &sites){
+	if ( ( starts.size() != chromosomes.size() ) || ( ends.size() != chromosomes.size() ) ) {
+		stringstream wrongThing;
+		wrongThing << "ERROR: the vectors of chromosome IDs (size = ";
+		wrongThing << chromosomes.size();
+		wrongThing << "), start positions (size = ";
+		wrongThing << starts.size();
+		wrongThing << "), and end positions (size = ";
+		wrongThing << ends.size();
+		wrongThing << ") are not the same size in getPolySites()";
+		throw wrongThing.str();
+	}
+	vector<size_t> queryRank;
+	vector<size_t> chromRank;
+	rankQueries_(chromosomes, queryRank, chromRank);
+	vector<size_t> order( starts.size() );
+	for (size_t iQuery = 0; iQuery < order.size(); iQuery++) {
+		if (starts[iQuery] > ends[iQuery]) {
+			stringstream wrongThing;
+			wrongThing << "ERROR: start position (";
+			wrongThing << starts[iQuery];
+			wrongThing << ") must not come after the end postion (";
+			wrongThing << ends[iQuery];
+			wrongThing << ") in getPolySites()";
+			throw wrongThing.str();
+		}
+		order[iQuery] = iQuery;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](const size_t &first, const size_t &second){
+		return (queryRank[first] < queryRank[second]) || ( (queryRank[first] == queryRank[second]) && (starts[first] < starts[second]) );
+	});
+
+	vector< pair<uint64_t, size_t> > open; // min-heap of (end, query index) of the ranges that can still contain the current record
+	const std::greater< pair<uint64_t, size_t> > endOrder;
+	vector<size_t> hits;
+	const size_t unranked = chromRank.size();
+	bool haveRecord       = !fullRecord_.empty();
+	size_t iOrder         = 0;
+	while ( iOrder < order.size() ) { // one chromosome at a time
+		const size_t curRank = queryRank[ order[iOrder] ];
+		size_t soughtQuery     = order.size();
+		open.clear();
+		while (true) {
+			if ( open.empty() ) {
+				if ( (iOrder == order.size()) || (queryRank[ order[iOrder] ] != curRank) ) { // no more ranges on this chromosome
 					break;
-				} else if (curPos > positions[i]) { // went past the current position; do the next one
+				}
+				if ( index_.loaded() && (soughtQuery != iOrder) ) { // jump over the gap to the next range if the index allows
+					soughtQuery = iOrder;
+					if ( !seekTo_(chromosomes[ order[iOrder] ], starts[ order[iOrder] ], ends[ order[iOrder] ]) ) {
+						iOrder++;
+						continue;
+					}
+					haveRecord = true;
+				}
+			}
+			if (!haveRecord) {
+				if ( index_.loaded() ) {
 					break;
 				}
-			} else if (foundChrom) {
-				completeChr_  = chromNames[i]; // we are on a new chromosome, past the previous one
-				foundChrom = false;
+				return;
+			}
+			const size_t recordRank = ( record_.chromosome() < chromRank.size() ? chromRank[record_.chromosome()] : unranked );
+			if ( (recordRank > curRank) && ( index_.loaded() || (recordRank != unranked) ) ) { // past the chromosome; with an index, records on chromosomes without ranges are too
 				break;
 			}
+			if (recordRank == curRank) {
+				const uint64_t position = record_.position();
+				while ( (iOrder < order.size()) && (queryRank[ order[iOrder] ] == curRank) && (starts[ order[iOrder] ] <= position) ) {
+					open.push_back( pair<uint64_t, size_t>(ends[ order[iOrder] ], order[iOrder]) );
+					std::push_heap(open.begin(), open.end(), endOrder);
+					iOrder++;
+				}
+				while ( !open.empty() && (open.front().first < position) ) {
+					std::pop_heap(open.begin(), open.end(), endOrder);
+					open.pop_back();
+				}
+				if ( !open.empty() ) { // every open range contains the record
+					hits.clear();
+					for (auto &eachOpen : open) {
+						hits.push_back(eachOpen.second);
+					}
+					std::sort( hits.begin(), hits.end() );
+					record_.parse( outgroupState_(axtObj_, record_) );
+					const PolySite site = record_.site();
+					for (auto &eachQuery : hits) {
+						sites.put(site, eachQuery);
+					}
+				}
+			}
+			haveRecord = nextRecord_();
+		}
+		// ranges on this chromosome that were not reached have no records
+		while ( (iOrder < order.size()) && (queryRank[ order[iOrder] ] == curRank) ) {
+			iOrder++;
 		}
 	}
 }
 
-void ParseVCF::parseCurrentRecord_(){
-	// we have a non-empty line, presumably a VCF record
-	stringstream metaSS(fullRecord_);
-	vector<string> fields;
-	string value;
-	while(metaSS >> value){ // makes sure we don't have anything extra at the end
-		fields.push_back(value);
-	}
+void ParseVCF::getPolySites(const vector<uint32_t> &chromosomes, const vector<uint64_t> &starts, const vector<uint64_t> &ends, PolySiteSink &sites, const size_t &nThreads){
+	vector< vector<QueryRegion> > regions;
+	groupQueries_(chromosomes, starts, ends, regions);
+	const size_t nWorkers    = (nThreads == 0 ? 1 : nThreads);
+	const size_t maxInFlight = 2 * nWorkers; // chunks read but not yet written; bounds memory use
 
-	varPos_  = strtoul(fields[1].c_str(), NULL, 0);
-	refID_   = fields[3][0];
-	altID_   = fields[4][0];
-	chrID_   = "chr" + fields[0];
-	quality_ = strtod(fields[5].c_str(), NULL);
+	/// A chunk of whole VCF lines
+	struct Chunk {
+		/// Position of the chunk in the file
+		size_t sequence;
+		/// Lines
+		string lines;
+	};
+	mutex queueMutex;
+	condition_variable queueChange;
+	deque<Chunk> pending;                                   // read and waiting for a worker
+	map< size_t, vector< pair<size_t, PolySite> > > done;  // scanned and waiting to be written
+	size_t nRead     = 0;
+	size_t nextWrite = 0;
+	bool readDone    = false;
+	bool abort       = false;
+	string errorMessage;
 
-	// count missing data; would be a bit faster to start from fields[9], but the overhead should be small at the expense of the better for loop
-	numMissing_ = 0;
-	for (auto &s : fields) {
-		if (s == "./.") {
-			numMissing_++;
+	auto fail = [&](const string &message){
+		lock_guard<mutex> lock(queueMutex);
+		if (!abort) {
+			abort        = true;
+			errorMessage = message;
+		}
+		queueChange.notify_all();
+	};
+
+	thread reader([&](){
+		try {
+			fstream plainFile;
+			BGZFfile compressedFile;
+			if (compressed_) {
+				compressedFile = BGZFfile(vcfFileName_);
+			} else {
+				try {
+					plainFile.exceptions(fstream::badbit);
+					plainFile.open(vcfFileName_.c_str(), ios::in | ios::binary);
+				} catch(system_error &error) {
+					string message = "ERROR: cannot open file " + vcfFileName_ + " to read: " + error.code().message();
+					throw message;
+				}
+			}
+			string carry; // incomplete last line of the previous read
+			while (true) {
+				Chunk chunk;
+				chunk.lines = move(carry);
+				carry.clear();
+				const size_t nCarried = chunk.lines.size();
+				chunk.lines.resize(nCarried + chunkSize_);
+				size_t nBytes = 0;
+				if (compressed_) {
+					nBytes = compressedFile.read(&chunk.lines[nCarried], chunkSize_);
+				} else {
+					plainFile.read(&chunk.lines[nCarried], static_cast<std::streamsize>(chunkSize_));
+					nBytes = static_cast<size_t>( plainFile.gcount() );
+				}
+				chunk.lines.resize(nCarried + nBytes);
+				const bool lastChunk = (nBytes == 0);
+				if (!lastChunk) {
+					const size_t lastLineEnd = chunk.lines.rfind('\n');
+					if (lastLineEnd == string::npos) { // a line longer than the chunk; keep reading
+						carry = move(chunk.lines);
+						continue;
+					}
+					carry.assign(chunk.lines, lastLineEnd + 1, string::npos);
+					chunk.lines.resize(lastLineEnd + 1);
+				}
+				unique_lock<mutex> lock(queueMutex);
+				queueChange.wait(lock, [&]{ return abort || (nRead - nextWrite < maxInFlight); });
+				if (abort) {
+					return;
+				}
+				if ( !chunk.lines.empty() ) {
+					chunk.sequence = nRead++;
+					pending.push_back( move(chunk) );
+				}
+				if (lastChunk) {
+					readDone = true;
+				}
+				queueChange.notify_all();
+				if (lastChunk) {
+					return;
+				}
+			}
+		} catch(string &error) {
+			fail(error);
+		} catch(std::exception &error) {
+			fail( string("ERROR: failed to read ") + vcfFileName_ + ": " + error.what() );
 		}
+	});
+
+	vector<thread> workers;
+	for (size_t iWorker = 0; iWorker < nWorkers; iWorker++) {
+		workers.push_back( thread([&](){
+			try {
+				ParseAXT outgroup(axtObj_);
+				VCFrecord record;
+				while (true) {
+					Chunk chunk;
+					{
+						unique_lock<mutex> lock(queueMutex);
+						queueChange.wait(lock, [&]{ return abort || !pending.empty() || readDone; });
+						if ( abort || pending.empty() ) {
+							return;
+						}
+						chunk = move( pending.front() );
+						pending.pop_front();
+					}
+					vector< pair<size_t, PolySite> > found;
+					scanChunk_(chunk.lines, regions, outgroup, record, found);
+					lock_guard<mutex> lock(queueMutex);
+					done[chunk.sequence] = move(found);
+					queueChange.notify_all();
+				}
+			} catch(string &error) {
+				fail(error);
+			} catch(std::exception &error) {
+				fail( string("ERROR: failed to scan ") + vcfFileName_ + ": " + error.what() );
+			}
+		}) );
 	}
-	// parse the INFO field
-	stringstream fSS(fields[7]);
-	string info;
-	while( getline(fSS, info, ';') ){
-		if (info.compare(0, 2, "AC") == 0) {
-			refAC_ = strtoul(info.c_str()+3, NULL, 0);
-		} else if (info.compare(0, 2, "AF") == 0) {
-			refAF_ = strtod(info.c_str()+3, NULL);
-		} else if (info.compare(0, 2, "AN") == 0) {
-			numCalled_ = strtoul(info.c_str()+3, NULL, 0);
-		} else if (info.compare(0, 5, "MLEAC") == 0) {
-			refMLAC_ = strtoul(info.c_str()+6, NULL, 0);
-		} else if (info.compare(0, 5, "MLEAF") == 0) {
-			refMLAF_ = strtod(info.c_str()+6, NULL);
+
+	// write the results in file order
+	try {
+		while (true) {
+			vector< pair<size_t, PolySite> > found;
+			{
+				unique_lock<mutex> lock(queueMutex);
+				queueChange.wait(lock, [&]{ return abort || (done.count(nextWrite) > 0) || (readDone && (nextWrite == nRead)); });
+				if ( abort || (done.count(nextWrite) == 0) ) {
+					break;
+				}
+				auto next = done.find(nextWrite);
+				found     = move(next->second);
+				done.erase(next);
+			}
+			for (auto &eachSite : found) {
+				sites.put(eachSite.second, eachSite.first);
+			}
+			lock_guard<mutex> lock(queueMutex);
+			nextWrite++;
+			queueChange.notify_all();
 		}
+	} catch(string &error) {
+		fail(error);
 	}
-	// Now find the ancestral state if we can
-	string outInfo;
-	axtObj_.getOutgroupState(chrID_, varPos_, outInfo);
-	if (outInfo[0] == 'N') {
-		ancState_ = 'u';
-		sameChr_  = 0;
-		outQual_  = 0;
-	} else {
-		ancState_ = (outInfo[0] == refID_ ? 'r' : 'a');
-		outQual_  = (outInfo[1] == '1' ? 1 : 0);
-		sameChr_  = (outInfo[2] == '1' ? 1 : 0);
+	reader.join();
+	for (auto &eachWorker : workers) {
+		eachWorker.join();
+	}
+	if (abort) {
+		throw errorMessage;
 	}
 }
 
-string ParseVCF::exportCurRecord_(){
-	stringstream siteInfo;
-	siteInfo << chrID_ << "\t";
-	siteInfo << varPos_ << "\t";
-	siteInfo << refID_ << "\t";
-	siteInfo << altID_ << "\t";
-	siteInfo << ancState_ << "\t";
-	if (ancState_ == 'a') {
-		siteInfo << numCalled_ - refAC_ << "\t";
-		siteInfo << numCalled_ - refMLAC_ << "\t";
-		siteInfo << 1.0 - refAF_ << "\t";
-		siteInfo << 1.0 - refMLAF_ << "\t";
-	} else {
-		siteInfo << refAC_ << "\t";
-		siteInfo << refMLAC_ << "\t";
-		siteInfo << refAF_ << "\t";
-		siteInfo << refMLAF_ << "\t";
+bool ParseVCF::readLine_(){
+	if (compressed_) {
+		recordOffset_ = bgzfFile_.tell();
+		return bgzfFile_.getline(fullRecord_);
 	}
-	siteInfo << numMissing_ << "\t";
-	siteInfo << sameChr_ << "\t";
-	siteInfo << outQual_ << "\t";
-	siteInfo << quality_;
+	return static_cast<bool>( getline(vcfFile_, fullRecord_) );
+}
 
-	return siteInfo.str();
+bool ParseVCF::seekTo_(const uint32_t &chromosome, const uint64_t &start, const uint64_t &end){
+	uint64_t offset = 0;
+	if ( !index_.firstOffset(genome_.name(chromosome), start, end, offset) ) {
+		return false;
+	}
+	completeChr_ = GenomeDictionary::missing; // with random access no chromosome is ever finished
+	if ( ( chromosome == record_.chromosome() ) && (record_.position() <= start) && (recordOffset_ >= offset) ) { // the current record is not past the region and no closer one is indexed; keep reading forward
+		return true;
+	}
+	bgzfFile_.seek(offset);
+	if ( !nextRecord_() ) {
+		fullRecord_.clear();
+		record_.clear();
+		return false;
+	}
+	return true;
+}
+
+bool ParseVCF::nextRecord_(){
+	while( readLine_() ){
+		if ( fullRecord_.empty() ) {
+			continue;
+		}
+		tokenizeRecord_();
+		return true;
+	}
+	return false;
+}
+
+uint32_t ParseVCF::chromosomeID(const string &chromName){
+	const size_t nKnown     = genome_.size();
+	const uint32_t chromosome = genome_.intern( GenomeDictionary::canonicalName(chromName) );
+	if ( ( genome_.size() > nKnown ) && !fullRecord_.empty() ) { // the current record may be on the new chromosome
+		tokenizeRecord_();
+	}
+	return chromosome;
+}
+
+void ParseVCF::rankQueries_(const vector<uint32_t> &chromosomes, vector<size_t> &queryRank, vector<size_t> &chromRank) const {
+	const size_t unranked = genome_.size();
+	chromRank.assign(unranked, unranked);
+	queryRank.clear();
+	queryRank.reserve( chromosomes.size() );
+	size_t nRanked = 0;
+	for (auto &eachChrom : chromosomes) {
+		if ( eachChrom >= genome_.size() ) {
+			throw string("ERROR: query chromosome ID is not in the chromosome dictionary in getPolySites()");
+		}
+		if (chromRank[eachChrom] == unranked) {
+			chromRank[eachChrom] = nRanked++;
+		}
+		queryRank.push_back(chromRank[eachChrom]);
+	}
+}
+
+void ParseVCF::groupQueries_(const vector<uint32_t> &chromosomes, const vector<uint64_t> &starts, const vector<uint64_t> &ends, vector< vector<QueryRegion> > &regions) const {
+	if ( ( starts.size() != chromosomes.size() ) || ( ends.size() != chromosomes.size() ) ) {
+		stringstream wrongThing;
+		wrongThing << "ERROR: the vectors of chromosome IDs (size = ";
+		wrongThing << chromosomes.size();
+		wrongThing << "), start positions (size = ";
+		wrongThing << starts.size();
+		wrongThing << "), and end positions (size = ";
+		wrongThing << ends.size();
+		wrongThing << ") are not the same size in getPolySites()";
+		throw wrongThing.str();
+	}
+	regions.assign( genome_.size(), vector<QueryRegion>() );
+	for (size_t iQuery = 0; iQuery < chromosomes.size(); iQuery++) {
+		if ( chromosomes[iQuery] >= genome_.size() ) {
+			throw string("ERROR: query chromosome ID is not in the chromosome dictionary in getPolySites()");
+		}
+		if (starts[iQuery] > ends[iQuery]) {
+			stringstream wrongThing;
+			wrongThing << "ERROR: start position (";
+			wrongThing << starts[iQuery];
+			wrongThing << ") must not come after the end postion (";
+			wrongThing << ends[iQuery];
+			wrongThing << ") in getPolySites()";
+			throw wrongThing.str();
+		}
+		QueryRegion query;
+		query.start  = starts[iQuery];
+		query.end    = ends[iQuery];
+		query.maxEnd = ends[iQuery];
+		query.query  = iQuery;
+		regions[ chromosomes[iQuery] ].push_back(query);
+	}
+	for (auto &chrRegions : regions) {
+		std::stable_sort(chrRegions.begin(), chrRegions.end(), [](const QueryRegion &first, const QueryRegion &second){ return first.start < second.start; });
+		for (size_t iRegion = 1; iRegion < chrRegions.size(); iRegion++) {
+			chrRegions[iRegion].maxEnd = std::max(chrRegions[iRegion].end, chrRegions[iRegion - 1].maxEnd);
+		}
+	}
 }
 
+void ParseVCF::scanChunk_(const string &chunk, const vector< vector<QueryRegion> > &regions, ParseAXT &outgroup, VCFrecord &record, vector< pair<size_t, PolySite> > &found) const {
+	const char *line     = chunk.data();
+	const char *chunkEnd = line + chunk.size();
+	vector<size_t> hits;
+	while (line < chunkEnd) {
+		const char *lineEnd = static_cast<const char*>( memchr(line, '\n', static_cast<size_t>(chunkEnd - line)) );
+		if (lineEnd == nullptr) {
+			lineEnd = chunkEnd;
+		}
+		const size_t lineLength = static_cast<size_t>(lineEnd - line);
+		if ( (lineLength == 0) || (line[0] == '#') ) {
+			line = lineEnd + 1;
+			continue;
+		}
+		record.tokenize(line, lineLength, genome_);
+		if ( record.chromosome() < regions.size() ) { // records on chromosomes that are not in the dictionary have no queries
+			const vector<QueryRegion> &chrRegions = regions[record.chromosome()];
+			const uint64_t position               = record.position();
+			// regions that start after the position are excluded; walk back through the rest until none can reach the position
+			size_t iRegion = static_cast<size_t>(std::upper_bound(chrRegions.begin(), chrRegions.end(), position, [](const uint64_t &pos, const QueryRegion &region){ return pos < region.start; }) - chrRegions.begin());
+			hits.clear();
+			while ( (iRegion > 0) && (chrRegions[iRegion - 1].maxEnd >= position) ) {
+				iRegion--;
+				if (chrRegions[iRegion].end >= position) {
+					hits.push_back(chrRegions[iRegion].query);
+				}
+			}
+			if ( !hits.empty() ) {
+				std::sort( hits.begin(), hits.end() );
+				record.parse( outgroupState_(outgroup, record) );
+				const PolySite site = record.site();
+				for (auto &eachQuery : hits) {
+					found.push_back( pair<size_t, PolySite>(eachQuery, site) );
+				}
+			}
+		}
+		line = lineEnd + 1;
+	}
+}
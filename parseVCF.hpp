@@ -33,104 +33,83 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <utility>
 
 #include "parseAXT.hpp"
+#include "genomeDictionary.hpp"
+#include "outgroupStates.hpp"
+#include "bgzfFile.hpp"
+#include "tabixIndex.hpp"
+#include "siteRecords.hpp"
 
 using std::fstream;
 using std::string;
 using std::vector;
+using std::pair;
 
 namespace BayesicSpace {
-	/** \brief VCF file parsing class
-	 *
-	 * Extracts information from a VCF file by position. Only SNPs are considered. The parsing is for the specific VCF files with fields defined in the dosage compensation project, may not be generally applicable.
+	/** \brief VCF record
 	 *
+	 * Parses one VCF line in place: the fixed fields are located without copying, and only the fields needed for a polymorphic site are converted.
+	 * Objects are independent of the file, so separate threads can parse records with separate objects.
 	 */
-	class ParseVCF {
+	class VCFrecord {
 		public:
 			/** \brief Default constructor */
-			ParseVCF() : varPos_{0}, refID_{'\0'}, altID_{'\0'}, ancState_{'u'}, outQual_{0}, sameChr_{0}, numMissing_{0}, numCalled_{0}, refAC_{0}, refMLAC_{0}, refAF_{0.0}, refMLAF_{0.0}, quality_{0.0}, chrID_{""}, completeChr_{""}, fullRecord_{""} { vcfFile_.exceptions(fstream::badbit); };
-			/** \brief Constructor with file names
-			 *
-			 * Opens the VCF file and the corresponding .axt alignment file for ancestral state tracking.
+			VCFrecord() : line_{nullptr}, lineLength_{0}, fieldStart_{0}, varPos_{0}, refID_{'\0'}, altID_{'\0'}, ancState_{'u'}, outQual_{0}, sameChr_{0}, numMissing_{0}, numCalled_{0}, refAC_{0}, refMLAC_{0}, refAF_{0.0}, refMLAF_{0.0}, quality_{0.0}, chromosome_{GenomeDictionary::missing}, genomeSize_{0} {};
+
+			/** \brief Tokenize a line
 			 *
-			 * \param[in] vcfFileName name of the VCF file
-			 * \param[in] axtFileName name of the .axt file
+			 * Records the offsets of the fixed fields and sets the chromosome ID and position. The line must stay in place until the record is parsed.
+			 * The chromosome name is looked up in the dictionary only if it differs from the previous record's or the dictionary has grown since.
 			 *
+			 * \param[in] line start of the line
+			 * \param[in] lineLength line length, excluding the line end
+			 * \param[in] genome chromosome dictionary
 			 */
-			ParseVCF(const string &vcfFileName, const string &axtFileName);
-
-			/** \brief Destructor */
-			~ParseVCF() { if(vcfFile_.is_open()) vcfFile_.close(); };
-			/// Copy constructor
-			ParseVCF(const ParseVCF &in) = delete;
-			/// Move constructor
-			ParseVCF(ParseVCF &&in) = delete;
-			/// Copy assignment
-			ParseVCF &operator=(const ParseVCF &in) = delete;
-			/// Move assignment
-			ParseAXT &operator=(ParseVCF &&in) = delete;
-
-			/** \brief Get list of polymorphic sites from a range
+			void tokenize(const char *line, const size_t &lineLength, const GenomeDictionary &genome);
+			/** \brief Parse the tokenized record
 			 *
-			 * Get a list of polymorphic sites from a range of positions on a chromosome.
-			 * The vector of sites is appended by the function, so any existing information will be preserved.
-			 * The site description is in a tab-delimited string with the following fields:
-			 *
-			 * - chromosome name
-			 * - position
-			 * - reference nucleotide
-			 * - alternative nucleotide
-			 * - which nucleotide is ancestral ('r' for reference, 'a' alternative, 'u' unknown)
-			 * - derived allele count
-			 * - derived allele count (maximum likelihood)
-			 * - derived allele frequency
-			 * - derived allele frequencey (maximum likelihood)
-			 * - number of missing genotypes
-			 * - whether the outgroup nucleotide is on the same chromosome as the polymorphic site
-			 * - whether the outgroup nucleotide is good quality
-			 * - site quality score
+			 * Parses the alleles, quality, INFO allele counts and frequencies, and missing genotypes in place, and sets the ancestral state.
 			 *
+			 * \param[in] outgroup encoded outgroup state of the record's position (see `OutgroupStates`)
+			 */
+			void parse(const uint8_t &outgroup);
+			/** \brief Site information
 			 *
-			 * _NOTE_: The range must be confined to a single chromosome.
+			 * Polarizes the allele counts and frequencies by the ancestral state.
 			 *
-			 * \param[in] chromName chromosome name
-			 * \param[in] start start position of the target range
-			 * \param[in] end end position of the target range
-			 * \param[out] sites vector of divergent site information (appended after execution)
+			 * \return the requisite site information
+			 */
+			PolySite site() const;
+			/** \brief Forget the record
 			 *
+			 * Clears the chromosome ID and position, so that the record matches no query.
 			 */
-			void getPolySites(const string &chromName, const uint64_t &start, const uint64_t &end, vector<string> &sites);
-			/** \brief Get list of polymorphic sites from a vector of positions
+			void clear() { chromosome_ = GenomeDictionary::missing; chrName_.clear(); genomeSize_ = 0; varPos_ = 0; };
+			/** \brief Chromosome ID
 			 *
-			 * Get a list of polymorphic sites from a vector of positions. The provided vector of cromosome names must be the same length as the vector of genome positions.
-			 * The chromosome names must be arranged in contiguous blocks, with the same order as in the target VCF file. This is to speed up file traversal.
-			 * The vector of sites is appended by the function, so any existing information will be preserved.
-			 * The site description is in a tab-delimited string with the following fields:
-			 *
-			 * - chromosome name
-			 * - position
-			 * - reference nucleotide
-			 * - alternative nucleotide
-			 * - which nucleotide is ancestral ('r' for reference, 'a' alternative, 'u' unknown)
-			 * - derived allele count
-			 * - derived allele count (maximum likelihood)
-			 * - derived allele frequency
-			 * - derived allele frequencey (maximum likelihood)
-			 * - number of missing genotypes
-			 * - whether the outgroup nucleotide is on the same chromosome as the polymorphic site
-			 * - whether the outgroup nucleotide is good quality
-			 * - site quality score
-			 *
-			 * \param[in] chromNames vector of chromosome names
-			 * \param[in] positions vector of query site genome positions
-			 * \param[out] sites vector of divergent site information (appended after execution)
+			 * \return chromosome ID in the dictionary used for tokenizing, `GenomeDictionary::missing` if the chromosome is not in it
+			 */
+			const uint32_t &chromosome() const { return chromosome_; };
+			/** \brief Position
 			 *
+			 * \return SNP position
 			 */
-			void getPolySites(const vector<string> &chromNames, const vector<uint64_t> &positions, vector<string> &sites);
-
+			const uint64_t &position() const { return varPos_; };
 		private:
-			// Variables for the current record
+			/// Start of the line
+			const char *line_;
+			/// Line length
+			size_t lineLength_;
+			/// Number of fixed (non-sample) VCF fields
+			static const size_t nFixedFields_ = 9;
+			/** \brief Field offsets
+			 *
+			 * Offsets of the fixed fields of the record in the line; the last element is the offset of the first sample column.
+			 * Field _i_ ends just before `fieldStart_[i + 1] - 1` (the tab). Fields absent from the record start one past the end of the line.
+			 */
+			size_t fieldStart_[nFixedFields_ + 1];
 			/// Current SNP position
 			uint64_t varPos_;
 			/// Reference nucleotide
@@ -164,24 +143,228 @@ namespace BayesicSpace {
 			/// Site quality score
 			double quality_;
 			/// Chromosome ID
-			string chrID_;
+			uint32_t chromosome_;
+			/// Chromosome name as written in the record
+			string chrName_;
+			/// Dictionary size when the chromosome ID was looked up
+			size_t genomeSize_;
+	};
+
+	/** \brief VCF file parsing class
+	 *
+	 * Extracts information from a VCF file by position. Only SNPs are considered. The parsing is for the specific VCF files with fields defined in the dosage compensation project, may not be generally applicable.
+	 *
+	 */
+	class ParseVCF {
+		public:
+			/** \brief Default constructor */
+			ParseVCF() : completeChr_{GenomeDictionary::missing}, fullRecord_{""}, vcfFileName_{""}, compressed_{false}, recordOffset_{0} { vcfFile_.exceptions(fstream::badbit); };
+			/** \brief Constructor with file names
+			 *
+			 * Opens the VCF file and the corresponding .axt alignment file for ancestral state tracking.
+			 * The VCF file can be plain text or compressed with `bgzip`. A compressed file with a tabix (VCF file name with `.tbi` appended) or CSI (`.csi` appended) index is read with random access.
+			 *
+			 * \param[in] vcfFileName name of the VCF file
+			 * \param[in] axtFileName name of the .axt file
+			 *
+			 */
+			ParseVCF(const string &vcfFileName, const string &axtFileName);
+
+			/** \brief Destructor */
+			~ParseVCF() { if(vcfFile_.is_open()) vcfFile_.close(); };
+			/// Copy constructor
+			ParseVCF(const ParseVCF &in) = delete;
+			/// Move constructor
+			ParseVCF(ParseVCF &&in) = delete;
+			/// Copy assignment
+			ParseVCF &operator=(const ParseVCF &in) = delete;
+			/// Move assignment
+			ParseAXT &operator=(ParseVCF &&in) = delete;
+
+			/** \brief Get list of polymorphic sites from a range
+			 *
+			 * Get a list of polymorphic sites from a range of positions on a chromosome.
+			 * Each site is passed to the sink as soon as it is found.
+			 * If the VCF file is indexed, reading starts at the first indexed block that can overlap the range, and ranges can be queried in any order.
+			 *
+			 * _NOTE_: The range must be confined to a single chromosome.
+			 *
+			 * \param[in] chromosome chromosome ID
+			 * \param[in] start start position of the target range
+			 * \param[in] end end position of the target range
+			 * \param[in,out] sites sink that receives the polymorphic sites
+			 *
+			 */
+			void getPolySites(const uint32_t &chromosome, const uint64_t &start, const uint64_t &end, PolySiteSink &sites);
+			/** \brief Get list of polymorphic sites from a vector of positions
+			 *
+			 * Get a list of polymorphic sites from a vector of positions. The provided vector of cromosome names must be the same length as the vector of genome positions.
+			 * Queries are sorted by chromosome (in order of first appearance among the queries) and position, and merged with the VCF records in one forward pass, so each record is read at most once.
+			 * Without an index, the chromosomes must therefore first appear among the queries in the same order as in the VCF file; positions within a chromosome can be in any order.
+			 * Records on chromosomes with no queries are skipped, and a query chromosome missing from the VCF file does not affect the others.
+			 * If the VCF file is indexed, the file is only read forward from positions that are not further than the next indexed block, and other positions are reached by seeking; chromosomes can then be in any order.
+			 * Each site is passed to the sink as soon as it is found, in the sorted query order. A record matches at most one query position, but repeated query positions each get the record.
+			 *
+			 * \param[in] chromosomes vector of chromosome IDs
+			 * \param[in] positions vector of query site genome positions
+			 * \param[in,out] sites sink that receives the polymorphic sites
+			 *
+			 */
+			void getPolySites(const vector<uint32_t> &chromosomes, const vector<uint64_t> &positions, PolySiteSink &sites);
+			/** \brief Get polymorphic sites from many ranges
+			 *
+			 * Sweeps the VCF file once for all ranges: ranges are sorted by chromosome (in order of first appearance among the queries) and start, and the ranges that can still contain the current record are kept in a min-heap by end.
+			 * Each record is passed to the sink once for every range that contains it (`PolySiteSink::put(const PolySite&, const size_t&)`, with query indexes in increasing order), so sites come in VCF file order.
+			 * Ranges within a chromosome can be in any order and can overlap. A range can be a single position (the same start and end).
+			 * Without an index, chromosomes must first appear among the ranges in the same order as in the VCF file. If the VCF file is indexed, gaps between ranges are skipped by seeking and chromosomes can be in any order.
+			 *
+			 * \param[in] chromosomes chromosome ID of each range
+			 * \param[in] starts first position of each range
+			 * \param[in] ends last position of each range
+			 * \param[in,out] sites sink that receives the polymorphic sites
+			 */
+			void getPolySites(const vector<uint32_t> &chromosomes, const vector<uint64_t> &starts, const vector<uint64_t> &ends, PolySiteSink &sites);
+			/** \brief Get polymorphic sites for many queries in parallel
+			 *
+			 * Reads the whole VCF file in large line-aligned chunks on one thread and hands the chunks to a pool of worker threads.
+			 * Workers tokenize the records, keep those that fall into a query range, and look up their ancestral states, each with its own copy of the .axt reader.
+			 * Results are passed to the sink in VCF file order, each with the index of every query range it falls into, in increasing order (`PolySiteSink::put(const PolySite&, const size_t&)`).
+			 * A single position is queried by setting the start and end to the same value. Queries can be in any order and can overlap.
+			 *
+			 * \param[in] chromosomes chromosome ID of each query
+			 * \param[in] starts first position of each query
+			 * \param[in] ends last position of each query
+			 * \param[in,out] sites sink that receives the polymorphic sites
+			 * \param[in] nThreads number of worker threads
+			 */
+			void getPolySites(const vector<uint32_t> &chromosomes, const vector<uint64_t> &starts, const vector<uint64_t> &ends, PolySiteSink &sites, const size_t &nThreads);
+			/** \brief Chromosome ID
+			 *
+			 * Looks up a query chromosome name, adding it to the dictionary if it is new. Names of one or two characters get "chr" in front, as in the .axt file.
+			 *
+			 * \param[in] chromName chromosome name
+			 * \return chromosome ID
+			 */
+			uint32_t chromosomeID(const string &chromName);
+			/** \brief Chromosome name
+			 *
+			 * \param[in] chromosome chromosome index from a site record
+			 * \return chromosome name
+			 */
+			const string &chromosomeName(const uint32_t &chromosome) const { return genome_.name(chromosome); };
+			/** \brief Chromosome names
+			 *
+			 * The dictionary starts with the .axt file chromosomes and grows as new query chromosomes are looked up.
+			 *
+			 * \return chromosome names, indexed by the site record chromosome index
+			 */
+			const vector<string> &chromosomeNames() const { return genome_.names(); };
+
+		private:
+			/// Query range with its index among the queries
+			struct QueryRegion {
+				/// First position
+				uint64_t start;
+				/// Last position
+				uint64_t end;
+				/// Largest `end` among this and all preceding ranges of the chromosome
+				uint64_t maxEnd;
+				/// Query index
+				size_t query;
+			};
+			/// Size of the chunks read by the parallel scan (4 MiB)
+			static const size_t chunkSize_ = 4194304;
+			/// Chromosome dictionary shared with the .axt file
+			GenomeDictionary genome_;
 			/// Last completely searched chromosome
-			string completeChr_;
+			uint32_t completeChr_;
 			/// The full VCF line (record)
 			string fullRecord_;
+			/// The current record
+			VCFrecord record_;
+			/// VCF file name
+			string vcfFileName_;
 
 			/// The file stream
 			fstream vcfFile_;
-			/// The corresponding .axt object
+			/// Is the VCF file BGZF-compressed?
+			bool compressed_;
+			/// The compressed VCF file
+			BGZFfile bgzfFile_;
+			/// The tabix or CSI index of the compressed file (empty if there is none)
+			TabixIndex index_;
+			/// Virtual offset of the current record in the compressed file
+			uint64_t recordOffset_;
+			/// The corresponding .axt object (not loaded if there is an outgroup state table)
 			ParseAXT axtObj_;
+			/// The outgroup state table of the .axt file, if there is a current one
+			OutgroupStates outgroupStates_;
 
-			/// Parse current record
-			void parseCurrentRecord_();
-			/** Export current record
+			/** \brief Read a line
+			 *
+			 * Reads the next line from the plain or compressed file into `fullRecord_`.
+			 *
+			 * \return false at the end of the file
+			 */
+			bool readLine_();
+			/** \brief Position the compressed file at a region
+			 *
+			 * Uses the index to load the first record that can overlap the region, unless the current record already precedes the region and is at or past the indexed offset.
+			 *
+			 * \param[in] chromosome chromosome ID
+			 * \param[in] start first position of the region
+			 * \param[in] end last position of the region
+			 * \return false if no records can overlap the region
+			 */
+			bool seekTo_(const uint32_t &chromosome, const uint64_t &start, const uint64_t &end);
+			/** \brief Read the next record
+			 *
+			 * Skips empty lines and tokenizes the record.
+			 *
+			 * \return false if there are no more records
+			 */
+			bool nextRecord_();
+			/** \brief Tokenize the current record */
+			void tokenizeRecord_() { record_.tokenize(fullRecord_.data(), fullRecord_.size(), genome_); };
+			/** \brief Rank query chromosomes
+			 *
+			 * \param[in] chromosomes chromosome ID of each query
+			 * \param[out] queryRank rank of each query's chromosome, in order of first appearance
+			 * \param[out] chromRank rank of each chromosome ID; chromosomes without queries get the number of chromosomes in the dictionary
+			 */
+			void rankQueries_(const vector<uint32_t> &chromosomes, vector<size_t> &queryRank, vector<size_t> &chromRank) const;
+			/** \brief Region queries by chromosome
+			 *
+			 * Builds the query lookup used by the parallel scan.
+			 *
+			 * \param[in] chromosomes chromosome ID of each query
+			 * \param[in] starts first position of each query
+			 * \param[in] ends last position of each query
+			 * \param[out] regions queries of each chromosome sorted by start, indexed by chromosome ID
+			 */
+			void groupQueries_(const vector<uint32_t> &chromosomes, const vector<uint64_t> &starts, const vector<uint64_t> &ends, vector< vector<QueryRegion> > &regions) const;
+			/** \brief Scan a chunk of the VCF file
+			 *
+			 * Finds the records in a chunk of whole lines that fall into the query ranges. Safe to run concurrently on different chunks, as long as each thread has its own record and .axt reader.
+			 *
+			 * \param[in] chunk chunk of whole VCF lines
+			 * \param[in] regions queries of each chromosome, as built by `groupQueries_()`
+			 * \param[in,out] outgroup .axt reader used for the outgroup states
+			 * \param[in,out] record record used for parsing
+			 * \param[out] found sites in file order, each paired with a query index; sites in several ranges are repeated with increasing query indexes
+			 */
+			void scanChunk_(const string &chunk, const vector< vector<QueryRegion> > &regions, ParseAXT &outgroup, VCFrecord &record, vector< pair<size_t, PolySite> > &found) const;
+			/** \brief Outgroup state of a record
+			 *
+			 * Looks the state up in the outgroup state table if there is one, and in the alignment otherwise.
 			 *
-			 * \return string with the requisite site information
+			 * \param[in,out] outgroup .axt reader used if there is no table
+			 * \param[in] record tokenized record
+			 * \return encoded outgroup state
 			 */
-			string exportCurRecord_();
+			uint8_t outgroupState_(ParseAXT &outgroup, const VCFrecord &record) const {
+				return outgroupStates_.loaded() ? outgroupStates_.state( record.chromosome(), record.position() ) : outgroup.getOutgroupState( record.chromosome(), record.position() );
+			};
 	};
 }
 
@@ -30,6 +30,7 @@
  * -a .axt file name (for the outgroup)
  * -v VCF file name
  * -o output file name
+ * -t number of threads (optional, default 1)
  *
  */
 
@@ -37,11 +38,10 @@
 #include <vector>
 #include <unordered_map>
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include <cctype>
 
 #include "parseVCF.hpp"
+#include "queryFile.hpp"
+#include "siteRecords.hpp"
 #include "utilities.hpp"
 
 using namespace BayesicSpace;
@@ -49,10 +49,6 @@ using std::vector;
 using std::unordered_map;
 using std::cerr;
 using std::endl;
-using std::fstream;
-using std::ofstream;
-using std::stringstream;
-using std::ios;
 
 using namespace BayesicSpace;
 
@@ -70,131 +66,43 @@ int main(int argc, char *argv[]){
 			throw string("Must specify output file name with flag -o");
 		}
 
-		ParseVCF vcf(clInfo['v'], clInfo['a']);
-
-		string qLine;
-		vector<string> chrNams;
-		vector<uint64_t> positions;
-
-		fstream queryFile;
-		queryFile.open(clInfo['q'].c_str(), ios::in);
-
-		// process first uncommented non-empty line and see how many fields we are dealing with
-		while ( getline(queryFile, qLine) ) {
-			if ( qLine.size() && (qLine[0] != '#') ){
-				break;
+		size_t nThreads = 1;
+		if ( !clInfo['t'].empty() ) {
+			nThreads = strtoul(clInfo['t'].c_str(), NULL, 0);
+			if (nThreads == 0) {
+				throw string("Number of threads (flag -t) must be a positive integer");
 			}
 		}
-		if ( queryFile.eof() ){
-			queryFile.close();
-			throw string("Query file has no uncommented non-empty lines");
-		}
-		stringstream firstLnSS(qLine);
-		vector<string> fields;
-		string firstValue;
-		while(firstLnSS >> firstValue){
-			fields.push_back(firstValue);
-		}
-		if (fields.size() < 2) {
-			queryFile.close();
-			throw string("Query file should have at least two white-space separated fields");
-		} else if (fields.size() == 2){ // positions file
-			if ( isdigit(fields[1][0]) ){
-				if (fields[0].size() <= 2){
-					fields[0] = "chr" + fields[0];
-				}
-				chrNams.push_back(fields[0]);
-				positions.push_back( strtoul(fields[1].c_str(), NULL, 0) );
-			}
-			while( getline(queryFile, qLine) ){
-				if ( qLine.empty() || (qLine[0] == '#') ){
-					continue;
-				}
-				stringstream lnSS(qLine);
-				vector<string> fields;
-				string value;
-				while(lnSS >> value){
-					fields.push_back(value);
-				}
-				if (fields.size() != 2) {
-					queryFile.close();
-					string error = "Line " + qLine + " does not have two fields in a positions query file";
-					throw error;
-				} else if ( !isdigit(fields[1][0]) ){
-					queryFile.close();
-					string error = fields[1] + " is not a numerical value in the position field";
-					throw error;
-				}
-				if (fields[0].size() <= 2){
-					fields[0] = "chr" + fields[0];
-				}
-				chrNams.push_back(fields[0]);
-				positions.push_back( strtoul(fields[1].c_str(), NULL, 0) );
-			}
-			queryFile.close();
-
-			vector<string> polySites;
-			vcf.getPolySites(chrNams, positions, polySites);
 
-			fstream outFile;
-			outFile.open(clInfo['o'].c_str(), ios::out | ios::trunc);
+		ParseVCF vcf(clInfo['v'], clInfo['a']);
 
-			// output the results
-			outFile << "CHR\tPOS\tREF\tALT\tANC\tAC\tMLAC\tAF\tMLAF\tNMISS\tSAME_CHR\tOUTQUAL\tSITEQUAL" << endl;
-			for (auto &ps : polySites) {
-				outFile << ps << endl;
+		QueryFile queries(clInfo['q']);
+		vector<uint32_t> vcfIDs;
+		for (auto &eachName : queries.chromosomeNames()) {
+			vcfIDs.push_back( vcf.chromosomeID(eachName) );
+		}
+		queries.renumber(vcfIDs);
+
+		if ( !queries.ranges() ) { // positions file
+			PolySiteFile outFile( clInfo['o'], vcf.chromosomeNames() );
+			outFile.putLine("CHR\tPOS\tREF\tALT\tANC\tAC\tMLAC\tAF\tMLAF\tNMISS\tSAME_CHR\tOUTQUAL\tSITEQUAL");
+			if (nThreads > 1) {
+				vcf.getPolySites(queries.chromosomes(), queries.positions(), queries.positions(), outFile, nThreads);
+			} else {
+				vcf.getPolySites(queries.chromosomes(), queries.positions(), outFile);
 			}
 			outFile.close();
 		} else { // ranges file
-			fstream outFile;
-			outFile.open(clInfo['o'].c_str(), ios::out | ios::trunc);
-			outFile << "PEAK_ID\tCHR\tPOS\tREF\tALT\tANC\tAC\tMLAC\tAF\tMLAF\tNMISS\tSAME_CHR\tOUTQUAL\tSITEQUAL" << endl;
-
-			uint32_t peakID = 1;
-			vector<string> polySites;
-			if ( isdigit(fields[1][0]) && isdigit(fields[2][0]) ){
-				if (fields[0].size() <= 2){
-					fields[0] = "chr" + fields[0];
-				}
-				chrNams.push_back(fields[0]);
-				positions.push_back( strtoul(fields[1].c_str(), NULL, 0) );
-				vcf.getPolySites(chrNams, positions, polySites);
-				for (auto &ps : polySites) {
-					outFile << "P" << peakID << "\t" << ps << endl;
-				}
-				peakID++;
-			}
-			while( getline(queryFile, qLine) ){
-				stringstream lnSS(qLine);
-				if ( qLine.empty() || (qLine[0] == '#') ){
-					continue;
-				}
-				vector<string> fields;
-				string value;
-				while(lnSS >> value){
-					fields.push_back(value);
-				}
-				if (fields.size() < 3) {
-					outFile.close();
-					queryFile.close();
-					string error = "Line " + qLine + " has fewer than three fields in a ranges query file";
-					throw error;
-				} else if ( !isdigit(fields[1][0]) || !isdigit(fields[2][0]) ){
-					outFile.close();
-					queryFile.close();
-					string error = "Field " + fields[1] + " or " + fields[2] + " is not numeric in the ranges query file";
-					throw error;
-				}
-				if (fields[0].size() <= 2){
-					fields[0] = "chr" + fields[0];
-				}
-				vcf.getPolySites(fields[0], strtoul(fields[1].c_str(), NULL, 0), strtoul(fields[2].c_str(), NULL, 0), polySites);
-				for (auto &ps : polySites) {
-					outFile << "P" << peakID << "\t" << ps << endl;
-				}
-				peakID++;
+			PolySiteFile outFile( clInfo['o'], vcf.chromosomeNames() );
+			outFile.putLine("PEAK_ID\tCHR\tPOS\tREF\tALT\tANC\tAC\tMLAC\tAF\tMLAF\tNMISS\tSAME_CHR\tOUTQUAL\tSITEQUAL");
+
+			// all ranges are searched at once, so overlapping ranges are only read once
+			outFile.setQueryPrefix("P");
+			if (nThreads > 1) {
+				vcf.getPolySites(queries.chromosomes(), queries.starts(), queries.ends(), outFile, nThreads);
+			} else {
+				vcf.getPolySites(queries.chromosomes(), queries.starts(), queries.ends(), outFile);
 			}
-			queryFile.close();
 			outFile.close();
 		}
 		exit(0);
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Query file loader
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Class implementation for loading position and range queries.
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cctype>
+#include <cstdint>
+
+#include "queryFile.hpp"
+#include "genomeDictionary.hpp"
+#include "mappedFile.hpp"
+#include "utilities.hpp"
+
+using std::string;
+using std::vector;
+
+using namespace BayesicSpace;
+
+QueryFile::QueryFile(const string &fileName) : ranges_{false} {
+	const bool bed = ( fileName.size() > 4 ) && (fileName.compare(fileName.size() - 4, 4, ".bed") == 0);
+	MappedFile queryFile(fileName);
+	const char *curChar = queryFile.data();
+	const char *fileEnd = curChar + queryFile.size();
+
+	const size_t maxFields = 3;
+	const char *fieldStart[maxFields];
+	size_t fieldLength[maxFields];
+	bool haveType = false; // set on the first uncommented non-empty line
+	// queries are usually grouped by chromosome, so the name is only looked up when it changes
+	const char *prevName = nullptr;
+	size_t prevLength    = 0;
+	uint32_t prevID      = GenomeDictionary::missing;
+	while (curChar < fileEnd) {
+		const char *lineStart = curChar;
+		const char *lineEnd   = static_cast<const char*>( memchr( lineStart, '\n', static_cast<size_t>(fileEnd - lineStart) ) );
+		if (lineEnd == nullptr) { // last line with no line end
+			lineEnd = fileEnd;
+			curChar = fileEnd;
+		} else {
+			curChar = lineEnd + 1;
+		}
+		if ( (lineEnd != lineStart) && (*(lineEnd - 1) == '\r') ) {
+			--lineEnd;
+		}
+		const size_t lineLength = static_cast<size_t>(lineEnd - lineStart);
+		if ( (lineLength == 0) || (*lineStart == '#') ) {
+			continue;
+		}
+		if ( bed && ( ( (lineLength >= 5) && (strncmp(lineStart, "track", 5) == 0) ) || ( (lineLength >= 7) && (strncmp(lineStart, "browser", 7) == 0) ) ) ) {
+			continue;
+		}
+		// split into fields in place; only the first three are kept, but all are counted
+		size_t nFields      = 0;
+		const char *lineChr = lineStart;
+		while (lineChr != lineEnd) {
+			if ( isspace(*lineChr) ) {
+				++lineChr;
+				continue;
+			}
+			const char *start = lineChr;
+			while ( (lineChr != lineEnd) && !isspace(*lineChr) ) {
+				++lineChr;
+			}
+			if (nFields < maxFields) {
+				fieldStart[nFields]  = start;
+				fieldLength[nFields] = static_cast<size_t>(lineChr - start);
+			}
+			nFields++;
+		}
+		if (nFields == 0) {
+			continue;
+		}
+		if (!haveType) {
+			if (nFields < 2) {
+				throw string("Query file should have at least two white-space separated fields");
+			} else if ( bed && (nFields < 3) ) {
+				throw string("BED query file should have at least three fields");
+			}
+			ranges_  = (nFields > 2);
+			haveType = true;
+			if ( !isdigit(*fieldStart[1]) || ( ranges_ && !isdigit(*fieldStart[2]) ) ) { // header
+				continue;
+			}
+		} else if (ranges_) {
+			if (nFields < 3) {
+				string error = "Line " + string(lineStart, lineLength) + " has fewer than three fields in a ranges query file";
+				throw error;
+			} else if ( !isdigit(*fieldStart[1]) || !isdigit(*fieldStart[2]) ) {
+				string error = "Field " + string(fieldStart[1], fieldLength[1]) + " or " + string(fieldStart[2], fieldLength[2]) + " is not numeric in the ranges query file";
+				throw error;
+			}
+		} else {
+			if (nFields != 2) {
+				string error = "Line " + string(lineStart, lineLength) + " does not have two fields in a positions query file";
+				throw error;
+			} else if ( !isdigit(*fieldStart[1]) ) {
+				string error = string(fieldStart[1], fieldLength[1]) + " is not a numerical value in the position field";
+				throw error;
+			}
+		}
+		if ( (prevID == GenomeDictionary::missing) || (fieldLength[0] != prevLength) || (memcmp(fieldStart[0], prevName, prevLength) != 0) ) {
+			prevID     = genome_.intern( string(fieldStart[0], fieldLength[0]) );
+			prevName   = fieldStart[0];
+			prevLength = fieldLength[0];
+		}
+		chromosomes_.push_back(prevID);
+		uint64_t value = 0;
+		parseUnsigned(fieldStart[1], fieldStart[1] + fieldLength[1], value);
+		if (bed) { // zero-based start
+			value++;
+		}
+		starts_.push_back(value);
+		if (ranges_) {
+			parseUnsigned(fieldStart[2], fieldStart[2] + fieldLength[2], value);
+			ends_.push_back(value);
+		}
+	}
+	if (!haveType) {
+		throw string("Query file has no uncommented non-empty lines");
+	}
+}
+
+void QueryFile::renumber(const vector<uint32_t> &newIDs){
+	if ( newIDs.size() != genome_.size() ) {
+		throw string("ERROR: number of new chromosome IDs does not match the number of query chromosomes in QueryFile::renumber()");
+	}
+	for (auto &eachChrom : chromosomes_) {
+		eachChrom = newIDs[eachChrom];
+	}
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Query file loader
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Class definition for loading position and range queries.
+ *
+ */
+
+#ifndef queryFile_hpp
+#define queryFile_hpp
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "genomeDictionary.hpp"
+
+using std::string;
+using std::vector;
+
+namespace BayesicSpace {
+	/** \brief Position or range queries
+	 *
+	 * Loads a query file into parallel arrays of chromosome IDs and positions (or range starts and ends).
+	 * The file is memory-mapped and parsed in place. Fields are separated by white space; commented (starting with `#`) and empty lines are skipped.
+	 * The first remaining line sets the file type: two fields make a positions file, three or more a ranges file (fields after the third are ignored).
+	 * This line is skipped as a header if the position (or start or end) field does not start with a digit.
+	 * Files with the `.bed` extension are BED ranges: `track` and `browser` lines are skipped and the zero-based, end-exclusive starts are converted to one-based positions.
+	 *
+	 * Chromosome names get IDs in the order they first appear in the file. Use `renumber()` to switch to the IDs of an .axt or VCF reader.
+	 */
+	class QueryFile {
+		public:
+			/** \brief Default constructor */
+			QueryFile() : ranges_{false} {};
+			/** \brief Constructor
+			 *
+			 * \param[in] fileName query file name
+			 */
+			QueryFile(const string &fileName);
+
+			/** \brief Is this a ranges file?
+			 *
+			 * \return true for ranges, false for positions
+			 */
+			bool ranges() const { return ranges_; };
+			/** \brief Number of queries
+			 *
+			 * \return number of positions or ranges
+			 */
+			size_t size() const { return chromosomes_.size(); };
+			/** \brief Chromosome of each query
+			 *
+			 * \return chromosome IDs
+			 */
+			const vector<uint32_t> &chromosomes() const { return chromosomes_; };
+			/** \brief Query positions
+			 *
+			 * \return positions, or range starts for a ranges file
+			 */
+			const vector<uint64_t> &positions() const { return starts_; };
+			/** \brief Range starts
+			 *
+			 * \return first position of each range (same as `positions()`)
+			 */
+			const vector<uint64_t> &starts() const { return starts_; };
+			/** \brief Range ends
+			 *
+			 * \return last position of each range; empty for a positions file
+			 */
+			const vector<uint64_t> &ends() const { return ends_; };
+			/** \brief Chromosome names
+			 *
+			 * \return chromosome names as written in the file, indexed by the IDs assigned while loading
+			 */
+			const vector<string> &chromosomeNames() const { return genome_.names(); };
+			/** \brief Change chromosome IDs
+			 *
+			 * Replaces each chromosome ID assigned while loading with the corresponding element of `newIDs`. Only call once.
+			 *
+			 * \param[in] newIDs new chromosome IDs, indexed by the IDs assigned while loading (the same order as `chromosomeNames()`)
+			 */
+			void renumber(const vector<uint32_t> &newIDs);
+		private:
+			/// Is this a ranges file?
+			bool ranges_;
+			/// Chromosome names in the order of first appearance
+			GenomeDictionary genome_;
+			/// Chromosome ID of each query
+			vector<uint32_t> chromosomes_;
+			/// Positions or range starts
+			vector<uint64_t> starts_;
+			/// Range ends
+			vector<uint64_t> ends_;
+	};
+}
+
+#endif /* queryFile_hpp */
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Bit vectors with rank support
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Implementation of a bit vector that counts set bits before any position in constant time.
+ *
+ */
+
+#include <vector>
+#include <cstdint>
+
+#include "rankBitVector.hpp"
+
+using std::vector;
+
+using namespace BayesicSpace;
+
+RankBitVector::RankBitVector(const uint64_t &nBits) : nBits_{nBits}, words_(nBits/64 + 1, 0) {
+	buildRank();
+}
+
+void RankBitVector::buildRank(){
+	const size_t nBlocks = (words_.size() + 7)/8;
+	directory_.assign(2*nBlocks, 0);
+	uint64_t total = 0;
+	for (size_t iBlock = 0; iBlock < nBlocks; iBlock++) {
+		directory_[2*iBlock] = total;
+		uint64_t inBlock = 0;
+		uint64_t packed  = 0;
+		for (size_t iWord = 0; iWord < 8; iWord++) {
+			const size_t wordIdx = 8*iBlock + iWord;
+			if (iWord) {
+				packed |= inBlock << ( 9*(iWord - 1) );
+			}
+			if ( wordIdx < words_.size() ) {
+				inBlock += static_cast<uint64_t>( __builtin_popcountll(words_[wordIdx]) );
+			}
+		}
+		directory_[2*iBlock + 1] = packed;
+		total += inBlock;
+	}
+}
+
+uint64_t RankBitVector::rank(const uint64_t &iBit) const {
+	const uint64_t bit     = (iBit < nBits_ ? iBit : nBits_);
+	const uint64_t wordIdx = bit/64;
+	const uint64_t iBlock  = wordIdx/8;
+	const uint64_t iWord   = wordIdx % 8;
+	uint64_t result = directory_[2*iBlock];
+	if (iWord) {
+		result += ( directory_[2*iBlock + 1] >> ( 9*(iWord - 1) ) ) & 0x1FF;
+	}
+	const uint64_t below = (static_cast<uint64_t>(1) << (bit % 64)) - 1;
+	return result + static_cast<uint64_t>( __builtin_popcountll(words_[wordIdx] & below) );
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Bit vectors with rank support
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Class definition for a bit vector that counts set bits before any position in constant time.
+ *
+ */
+
+#ifndef rankBitVector_hpp
+#define rankBitVector_hpp
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using std::vector;
+
+namespace BayesicSpace {
+	/** \brief Bit vector with rank queries
+	 *
+	 * Bits are set one at a time and the rank directory is built once all bits are in place.
+	 * The directory follows the rank9 layout: every 512-bit block has the number of set bits before it, and the seven within-block counts at the starts of its second to eighth words packed nine bits each into another 64-bit word.
+	 * A rank query then reads the two directory words and counts the bits of one data word, so it takes constant time, and the directory adds a quarter to the size of the bits.
+	 */
+	class RankBitVector {
+		public:
+			/** \brief Default constructor */
+			RankBitVector() : nBits_{0} {};
+			/** \brief Constructor
+			 *
+			 * All bits are unset.
+			 *
+			 * \param[in] nBits number of bits
+			 */
+			RankBitVector(const uint64_t &nBits);
+
+			/** \brief Number of bits */
+			uint64_t size() const { return nBits_; };
+			/** \brief Set a bit
+			 *
+			 * Invalidates the rank directory until `buildRank()` is called again.
+			 *
+			 * \param[in] iBit bit index
+			 */
+			void set(const uint64_t &iBit) { words_[iBit/64] |= static_cast<uint64_t>(1) << (iBit % 64); };
+			/** \brief Test a bit
+			 *
+			 * \param[in] iBit bit index
+			 * \return `true` if the bit is set
+			 */
+			bool test(const uint64_t &iBit) const { return (words_[iBit/64] >> (iBit % 64)) & 1; };
+			/** \brief Build the rank directory */
+			void buildRank();
+			/** \brief Rank
+			 *
+			 * Indexes past the end are treated as the end.
+			 *
+			 * \param[in] iBit bit index
+			 * \return number of set bits before `iBit`
+			 */
+			uint64_t rank(const uint64_t &iBit) const;
+			/** \brief Count set bits in a range
+			 *
+			 * \param[in] first first bit index
+			 * \param[in] last last bit index (included)
+			 * \return number of set bits between `first` and `last`
+			 */
+			uint64_t count(const uint64_t &first, const uint64_t &last) const { return (last < first ? 0 : rank(last + 1) - rank(first)); };
+		private:
+			/// Number of bits
+			uint64_t nBits_;
+			/** \brief Bits
+			 *
+			 * Has one more word than the bits need, so that the rank at the end can be read like any other.
+			 */
+			vector<uint64_t> words_;
+			/** \brief Rank directory
+			 *
+			 * Two words per 512-bit block: the number of set bits before the block, and the packed within-block counts.
+			 */
+			vector<uint64_t> directory_;
+	};
+}
+#endif /* rankBitVector_hpp */
@@ -0,0 +1,419 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Vectorized sequence kernels
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Implementation of vectorized (SSE2/AVX2) sequence classification and genotype counting kernels. The instruction set is chosen at run time, with a scalar fallback.
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BAYESIC_X86_KERNELS
+#endif
+
+#include "simdKernels.hpp"
+
+using std::vector;
+
+namespace BayesicSpace {
+	/// Kernel classifying 64-column chunks
+	typedef void (*MaskKernel)(const char*, const char*, const size_t&, uint64_t*, uint64_t*, uint64_t*, uint64_t*, uint64_t*);
+
+	/** \brief Classify up to 64 columns without vector instructions
+	 *
+	 * \param[in] primary primary sequence
+	 * \param[in] aligned aligned sequence
+	 * \param[in] nColumns number of columns (no more than 64)
+	 * \param[out] primaryGap primary sequence gap mask word
+	 * \param[out] alignedGap aligned sequence gap mask word
+	 * \param[out] unknown unknown nucleotide mask word
+	 * \param[out] match case-insensitive match mask word
+	 * \param[out] upper both upper case mask word
+	 */
+	static void scalarWord(const char *primary, const char *aligned, const size_t &nColumns, uint64_t &primaryGap, uint64_t &alignedGap, uint64_t &unknown, uint64_t &match, uint64_t &upper){
+		primaryGap = 0;
+		alignedGap = 0;
+		unknown    = 0;
+		match      = 0;
+		upper      = 0;
+		for (size_t i = 0; i < nColumns; i++) {
+			const unsigned char p  = static_cast<unsigned char>(primary[i]);
+			const unsigned char a  = static_cast<unsigned char>(aligned[i]);
+			const unsigned char lp = p | 0x20;
+			const unsigned char la = a | 0x20;
+			const uint64_t bit     = static_cast<uint64_t>(1) << i;
+			if (p == '-') {
+				primaryGap |= bit;
+			}
+			if (a == '-') {
+				alignedGap |= bit;
+			}
+			if ( (lp == 'n') || (la == 'n') ) {
+				unknown |= bit;
+			}
+			if ( (p == a) || ( ( (p ^ a) == 0x20 ) && (lp >= 'a') && (lp <= 'z') ) ) {
+				match |= bit;
+			}
+			if ( (p >= 'A') && (p <= 'Z') && (a >= 'A') && (a <= 'Z') ) {
+				upper |= bit;
+			}
+		}
+	}
+
+	/** \brief Scalar kernel
+	 *
+	 * Processes whole 64-column words.
+	 */
+	static void scalarKernel(const char *primary, const char *aligned, const size_t &nWords, uint64_t *primaryGap, uint64_t *alignedGap, uint64_t *unknown, uint64_t *match, uint64_t *upper){
+		for (size_t iWord = 0; iWord < nWords; iWord++) {
+			scalarWord(primary + 64*iWord, aligned + 64*iWord, 64, primaryGap[iWord], alignedGap[iWord], unknown[iWord], match[iWord], upper[iWord]);
+		}
+	}
+
+#ifdef BAYESIC_X86_KERNELS
+	/** \brief SSE2 kernel
+	 *
+	 * Processes whole 64-column words, 16 columns at a time.
+	 */
+	__attribute__((target("sse2")))
+	static void sse2Kernel(const char *primary, const char *aligned, const size_t &nWords, uint64_t *primaryGap, uint64_t *alignedGap, uint64_t *unknown, uint64_t *match, uint64_t *upper){
+		const __m128i dash   = _mm_set1_epi8('-');
+		const __m128i lowBit = _mm_set1_epi8(0x20);
+		const __m128i lowN   = _mm_set1_epi8('n');
+		const __m128i belowA = _mm_set1_epi8('A' - 1);
+		const __m128i aboveZ = _mm_set1_epi8('Z' + 1);
+		const __m128i belowa = _mm_set1_epi8('a' - 1);
+		const __m128i abovez = _mm_set1_epi8('z' + 1);
+		for (size_t iWord = 0; iWord < nWords; iWord++) {
+			uint64_t pg = 0;
+			uint64_t ag = 0;
+			uint64_t un = 0;
+			uint64_t mt = 0;
+			uint64_t up = 0;
+			for (size_t iChunk = 0; iChunk < 4; iChunk++) {
+				const size_t offset = 64*iWord + 16*iChunk;
+				const __m128i p     = _mm_loadu_si128( reinterpret_cast<const __m128i*>(primary + offset) );
+				const __m128i a     = _mm_loadu_si128( reinterpret_cast<const __m128i*>(aligned + offset) );
+				const __m128i lp    = _mm_or_si128(p, lowBit);
+				const __m128i la    = _mm_or_si128(a, lowBit);
+				// signed comparisons are fine: bytes above 0x7F are negative and fall outside the letter ranges
+				const __m128i alphaP  = _mm_and_si128( _mm_cmpgt_epi8(lp, belowa), _mm_cmplt_epi8(lp, abovez) );
+				const __m128i caseFlp = _mm_and_si128( _mm_cmpeq_epi8(_mm_xor_si128(p, a), lowBit), alphaP );
+				const __m128i upP     = _mm_and_si128( _mm_cmpgt_epi8(p, belowA), _mm_cmplt_epi8(p, aboveZ) );
+				const __m128i upA     = _mm_and_si128( _mm_cmpgt_epi8(a, belowA), _mm_cmplt_epi8(a, aboveZ) );
+				const unsigned shift  = static_cast<unsigned>(16*iChunk);
+				pg |= static_cast<uint64_t>( static_cast<uint16_t>( _mm_movemask_epi8( _mm_cmpeq_epi8(p, dash) ) ) ) << shift;
+				ag |= static_cast<uint64_t>( static_cast<uint16_t>( _mm_movemask_epi8( _mm_cmpeq_epi8(a, dash) ) ) ) << shift;
+				un |= static_cast<uint64_t>( static_cast<uint16_t>( _mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi8(lp, lowN), _mm_cmpeq_epi8(la, lowN) ) ) ) ) << shift;
+				mt |= static_cast<uint64_t>( static_cast<uint16_t>( _mm_movemask_epi8( _mm_or_si128(_mm_cmpeq_epi8(p, a), caseFlp) ) ) ) << shift;
+				up |= static_cast<uint64_t>( static_cast<uint16_t>( _mm_movemask_epi8( _mm_and_si128(upP, upA) ) ) ) << shift;
+			}
+			primaryGap[iWord] = pg;
+			alignedGap[iWord] = ag;
+			unknown[iWord]    = un;
+			match[iWord]      = mt;
+			upper[iWord]      = up;
+		}
+	}
+
+	/** \brief AVX2 kernel
+	 *
+	 * Processes whole 64-column words, 32 columns at a time.
+	 */
+	__attribute__((target("avx2")))
+	static void avx2Kernel(const char *primary, const char *aligned, const size_t &nWords, uint64_t *primaryGap, uint64_t *alignedGap, uint64_t *unknown, uint64_t *match, uint64_t *upper){
+		const __m256i dash   = _mm256_set1_epi8('-');
+		const __m256i lowBit = _mm256_set1_epi8(0x20);
+		const __m256i lowN   = _mm256_set1_epi8('n');
+		const __m256i belowA = _mm256_set1_epi8('A' - 1);
+		const __m256i aboveZ = _mm256_set1_epi8('Z' + 1);
+		const __m256i belowa = _mm256_set1_epi8('a' - 1);
+		const __m256i abovez = _mm256_set1_epi8('z' + 1);
+		for (size_t iWord = 0; iWord < nWords; iWord++) {
+			uint64_t pg = 0;
+			uint64_t ag = 0;
+			uint64_t un = 0;
+			uint64_t mt = 0;
+			uint64_t up = 0;
+			for (size_t iChunk = 0; iChunk < 2; iChunk++) {
+				const size_t offset = 64*iWord + 32*iChunk;
+				const __m256i p     = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(primary + offset) );
+				const __m256i a     = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(aligned + offset) );
+				const __m256i lp    = _mm256_or_si256(p, lowBit);
+				const __m256i la    = _mm256_or_si256(a, lowBit);
+				// signed comparisons are fine: bytes above 0x7F are negative and fall outside the letter ranges
+				const __m256i alphaP  = _mm256_and_si256( _mm256_cmpgt_epi8(lp, belowa), _mm256_cmpgt_epi8(abovez, lp) );
+				const __m256i caseFlp = _mm256_and_si256( _mm256_cmpeq_epi8(_mm256_xor_si256(p, a), lowBit), alphaP );
+				const __m256i upP     = _mm256_and_si256( _mm256_cmpgt_epi8(p, belowA), _mm256_cmpgt_epi8(aboveZ, p) );
+				const __m256i upA     = _mm256_and_si256( _mm256_cmpgt_epi8(a, belowA), _mm256_cmpgt_epi8(aboveZ, a) );
+				const unsigned shift  = static_cast<unsigned>(32*iChunk);
+				pg |= static_cast<uint64_t>( static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpeq_epi8(p, dash) ) ) ) << shift;
+				ag |= static_cast<uint64_t>( static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpeq_epi8(a, dash) ) ) ) << shift;
+				un |= static_cast<uint64_t>( static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_or_si256( _mm256_cmpeq_epi8(lp, lowN), _mm256_cmpeq_epi8(la, lowN) ) ) ) ) << shift;
+				mt |= static_cast<uint64_t>( static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_or_si256(_mm256_cmpeq_epi8(p, a), caseFlp) ) ) ) << shift;
+				up |= static_cast<uint64_t>( static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_and_si256(upP, upA) ) ) ) << shift;
+			}
+			primaryGap[iWord] = pg;
+			alignedGap[iWord] = ag;
+			unknown[iWord]    = un;
+			match[iWord]      = mt;
+			upper[iWord]      = up;
+		}
+	}
+#endif
+
+	/** \brief Pick the best kernel for the CPU
+	 *
+	 * \return pointer to the kernel function
+	 */
+	static MaskKernel chooseMaskKernel(){
+#ifdef BAYESIC_X86_KERNELS
+		__builtin_cpu_init();
+		if ( __builtin_cpu_supports("avx2") ) {
+			return avx2Kernel;
+		} else if ( __builtin_cpu_supports("sse2") ) {
+			return sse2Kernel;
+		}
+#endif
+		return scalarKernel;
+	}
+
+	/// Kernel used for full words, chosen once at start-up
+	static const MaskKernel maskKernel = chooseMaskKernel();
+
+	/// Character class masks of a 64-byte VCF sample region word
+	struct GenotypeClasses {
+		/// Tab
+		uint64_t tab;
+		/// Missing allele (`.`)
+		uint64_t dot;
+		/// Allele separator (`/` or `|`)
+		uint64_t separator;
+		/// Sub-field separator (`:`)
+		uint64_t colon;
+	};
+
+	/// Kernel classifying 64-byte words of a VCF sample region
+	typedef void (*GenotypeKernel)(const char*, GenotypeClasses&);
+
+	/** \brief Classify up to 64 bytes of a sample region without vector instructions
+	 *
+	 * Bytes past the end are marked as tabs, so that the end of the line delimits the last sample.
+	 *
+	 * \param[in] bytes sample region bytes
+	 * \param[in] nBytes number of bytes (no more than 64)
+	 * \param[out] classes character class masks
+	 */
+	static void scalarGenotypeWord(const char *bytes, const size_t &nBytes, GenotypeClasses &classes){
+		classes.tab       = (nBytes < 64 ? ~( (static_cast<uint64_t>(1) << nBytes) - 1 ) : 0);
+		classes.dot       = 0;
+		classes.separator = 0;
+		classes.colon     = 0;
+		for (size_t i = 0; i < nBytes; i++) {
+			const uint64_t bit = static_cast<uint64_t>(1) << i;
+			switch (bytes[i]) {
+				case '\t':
+					classes.tab |= bit;
+					break;
+				case '.':
+					classes.dot |= bit;
+					break;
+				case '/':
+				case '|':
+					classes.separator |= bit;
+					break;
+				case ':':
+					classes.colon |= bit;
+					break;
+				default:
+					break;
+			}
+		}
+	}
+
+	/** \brief Scalar genotype kernel
+	 *
+	 * Classifies a whole 64-byte word.
+	 */
+	static void scalarGenotypeKernel(const char *bytes, GenotypeClasses &classes){
+		scalarGenotypeWord(bytes, 64, classes);
+	}
+
+#ifdef BAYESIC_X86_KERNELS
+	/** \brief SSE2 genotype kernel
+	 *
+	 * Classifies a whole 64-byte word, 16 bytes at a time.
+	 */
+	__attribute__((target("sse2")))
+	static void sse2GenotypeKernel(const char *bytes, GenotypeClasses &classes){
+		const __m128i tab   = _mm_set1_epi8('\t');
+		const __m128i dot   = _mm_set1_epi8('.');
+		const __m128i slash = _mm_set1_epi8('/');
+		const __m128i pipe  = _mm_set1_epi8('|');
+		const __m128i colon = _mm_set1_epi8(':');
+		classes.tab       = 0;
+		classes.dot       = 0;
+		classes.separator = 0;
+		classes.colon     = 0;
+		for (size_t iChunk = 0; iChunk < 4; iChunk++) {
+			const __m128i b      = _mm_loadu_si128( reinterpret_cast<const __m128i*>(bytes + 16*iChunk) );
+			const unsigned shift = static_cast<unsigned>(16*iChunk);
+			classes.tab       |= static_cast<uint64_t>( static_cast<uint16_t>( _mm_movemask_epi8( _mm_cmpeq_epi8(b, tab) ) ) ) << shift;
+			classes.dot       |= static_cast<uint64_t>( static_cast<uint16_t>( _mm_movemask_epi8( _mm_cmpeq_epi8(b, dot) ) ) ) << shift;
+			classes.separator |= static_cast<uint64_t>( static_cast<uint16_t>( _mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi8(b, slash), _mm_cmpeq_epi8(b, pipe) ) ) ) ) << shift;
+			classes.colon     |= static_cast<uint64_t>( static_cast<uint16_t>( _mm_movemask_epi8( _mm_cmpeq_epi8(b, colon) ) ) ) << shift;
+		}
+	}
+
+	/** \brief AVX2 genotype kernel
+	 *
+	 * Classifies a whole 64-byte word, 32 bytes at a time.
+	 */
+	__attribute__((target("avx2")))
+	static void avx2GenotypeKernel(const char *bytes, GenotypeClasses &classes){
+		const __m256i tab   = _mm256_set1_epi8('\t');
+		const __m256i dot   = _mm256_set1_epi8('.');
+		const __m256i slash = _mm256_set1_epi8('/');
+		const __m256i pipe  = _mm256_set1_epi8('|');
+		const __m256i colon = _mm256_set1_epi8(':');
+		classes.tab       = 0;
+		classes.dot       = 0;
+		classes.separator = 0;
+		classes.colon     = 0;
+		for (size_t iChunk = 0; iChunk < 2; iChunk++) {
+			const __m256i b      = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(bytes + 32*iChunk) );
+			const unsigned shift = static_cast<unsigned>(32*iChunk);
+			classes.tab       |= static_cast<uint64_t>( static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpeq_epi8(b, tab) ) ) ) << shift;
+			classes.dot       |= static_cast<uint64_t>( static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpeq_epi8(b, dot) ) ) ) << shift;
+			classes.separator |= static_cast<uint64_t>( static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_or_si256( _mm256_cmpeq_epi8(b, slash), _mm256_cmpeq_epi8(b, pipe) ) ) ) ) << shift;
+			classes.colon     |= static_cast<uint64_t>( static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpeq_epi8(b, colon) ) ) ) << shift;
+		}
+	}
+#endif
+
+	/** \brief Pick the best genotype kernel for the CPU
+	 *
+	 * \return pointer to the kernel function
+	 */
+	static GenotypeKernel chooseGenotypeKernel(){
+#ifdef BAYESIC_X86_KERNELS
+		__builtin_cpu_init();
+		if ( __builtin_cpu_supports("avx2") ) {
+			return avx2GenotypeKernel;
+		} else if ( __builtin_cpu_supports("sse2") ) {
+			return sse2GenotypeKernel;
+		}
+#endif
+		return scalarGenotypeKernel;
+	}
+
+	/// Genotype kernel used for full words, chosen once at start-up
+	static const GenotypeKernel genotypeKernel = chooseGenotypeKernel();
+
+	/** \brief Classify a word of a sample region
+	 *
+	 * Uses the vector kernel for full words and the scalar version for the tail.
+	 *
+	 * \param[in] samples sample region
+	 * \param[in] nBytes sample region length in bytes
+	 * \param[in] iWord word index
+	 * \param[out] classes character class masks
+	 */
+	static inline void genotypeWord(const char *samples, const size_t &nBytes, const size_t &iWord, GenotypeClasses &classes){
+		const size_t offset = 64*iWord;
+		if (nBytes - offset >= 64) {
+			genotypeKernel(samples + offset, classes);
+		} else {
+			scalarGenotypeWord(samples + offset, nBytes - offset, classes);
+		}
+	}
+}
+
+void BayesicSpace::alignmentMasks(const char *primary, const char *aligned, const size_t &nColumns, uint64_t *primaryGap, uint64_t *alignedGap, uint64_t *unknown, uint64_t *match, uint64_t *upper){
+	const size_t nFull = nColumns/64;
+	maskKernel(primary, aligned, nFull, primaryGap, alignedGap, unknown, match, upper);
+	const size_t nLeft = nColumns - 64*nFull;
+	if (nLeft) {
+		const size_t offset = 64*nFull;
+		scalarWord(primary + offset, aligned + offset, nLeft, primaryGap[nFull], alignedGap[nFull], unknown[nFull], match[nFull], upper[nFull]);
+	}
+}
+
+uint32_t BayesicSpace::countMissingGenotypes(const char *samples, const size_t &nBytes, vector<uint64_t> *missing){
+	if (missing != nullptr) {
+		missing->clear();
+	}
+	if (nBytes == 0) {
+		return 0;
+	}
+	const size_t nWords = (nBytes + 63)/64;
+	GenotypeClasses current;
+	GenotypeClasses next;
+	genotypeWord(samples, nBytes, 0, current);
+	uint64_t previousTab = 1;  // the region starts with a sample, as if preceded by a tab
+	uint64_t nSamples    = 0;  // samples starting before the current word
+	uint32_t nMissing    = 0;
+	for (size_t iWord = 0; iWord < nWords; iWord++) {
+		if (iWord + 1 < nWords) {
+			genotypeWord(samples, nBytes, iWord + 1, next);
+		} else { // past the end of the line everything is a delimiter
+			next.tab       = ~static_cast<uint64_t>(0);
+			next.dot       = 0;
+			next.separator = 0;
+			next.colon     = 0;
+		}
+		const size_t nLeft       = nBytes - 64*iWord;
+		const uint64_t valid     = ( nLeft >= 64 ? ~static_cast<uint64_t>(0) : (static_cast<uint64_t>(1) << nLeft) - 1 );
+		const uint64_t start     = ( (current.tab << 1) | previousTab ) & valid;
+		const uint64_t delimiter = current.tab | current.colon;
+		const uint64_t nextDelim = next.tab | next.colon;
+		// shift masks down so that bit i says something about byte i + k, pulling the top bits from the next word
+		const uint64_t delimAt1  = (delimiter >> 1) | (nextDelim << 63);
+		const uint64_t delimAt3  = (delimiter >> 3) | (nextDelim << 61);
+		const uint64_t sepAt1    = (current.separator >> 1) | (next.separator << 63);
+		const uint64_t dotAt2    = (current.dot >> 2) | (next.dot << 62);
+		// "." or "./." (".|.") followed by the end of the sample or of the GT sub-field
+		const uint64_t missWord  = start & current.dot & ( delimAt1 | (sepAt1 & dotAt2 & delimAt3) );
+		nMissing += static_cast<uint32_t>( __builtin_popcountll(missWord) );
+		if (missing != nullptr) {
+			const size_t nSampleWords = static_cast<size_t>( (nSamples + static_cast<uint64_t>( __builtin_popcountll(start) ) + 63)/64 );
+			missing->resize(nSampleWords, 0);
+			uint64_t toSet = missWord;
+			while (toSet) {
+				const uint64_t bit     = toSet & (~toSet + 1);
+				const uint64_t iSample = nSamples + static_cast<uint64_t>( __builtin_popcountll( start & (bit - 1) ) );
+				(*missing)[iSample/64] |= static_cast<uint64_t>(1) << (iSample % 64);
+				toSet ^= bit;
+			}
+		}
+		nSamples   += static_cast<uint64_t>( __builtin_popcountll(start) );
+		previousTab = current.tab >> 63;
+		current     = next;
+	}
+	return nMissing;
+}
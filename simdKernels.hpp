@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Vectorized sequence kernels
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Function definitions and interface documentation for vectorized (SSE2/AVX2) sequence classification and genotype counting kernels. The instruction set is chosen at run time, with a scalar fallback.
+ *
+ */
+
+#ifndef simdKernels_hpp
+#define simdKernels_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using std::vector;
+
+namespace BayesicSpace {
+	/** \brief Classify aligned sequence columns
+	 *
+	 * Compares two equal-length aligned sequences and sets one bit per alignment column in each of five bitmasks.
+	 * Bit `i % 64` of word `i / 64` corresponds to column `i`; bits past the last column are zero. Each mask array must hold at least `(nColumns + 63)/64` words.
+	 * The masks are
+	 *
+	 * - `primaryGap`: the primary nucleotide is a gap (`-`)
+	 * - `alignedGap`: the aligned nucleotide is a gap
+	 * - `unknown`: either nucleotide is unknown (`n` or `N`)
+	 * - `match`: the nucleotides are the same, ignoring case
+	 * - `upper`: both nucleotides are in upper case (indicating high quality base calls)
+	 *
+	 * \param[in] primary primary sequence
+	 * \param[in] aligned aligned sequence
+	 * \param[in] nColumns number of alignment columns
+	 * \param[out] primaryGap primary sequence gap mask
+	 * \param[out] alignedGap aligned sequence gap mask
+	 * \param[out] unknown unknown nucleotide mask
+	 * \param[out] match case-insensitive match mask
+	 * \param[out] upper both upper case mask
+	 */
+	void alignmentMasks(const char *primary, const char *aligned, const size_t &nColumns, uint64_t *primaryGap, uint64_t *alignedGap, uint64_t *unknown, uint64_t *match, uint64_t *upper);
+	/** \brief Count missing genotypes
+	 *
+	 * Scans the tab-delimited sample columns of a VCF record once, without tokenizing them.
+	 * A genotype is missing if its GT sub-field (everything before the first `:`) is `./.`, `.|.`, or `.`.
+	 * Optionally, sets one bit per missing sample (bit `i % 64` of word `i / 64` for sample `i`) in a bitset sized to the number of samples.
+	 *
+	 * \param[in] samples start of the first sample column
+	 * \param[in] nBytes length of the sample region in bytes, excluding the line end
+	 * \param[out] missing missing sample bitset (ignored if `nullptr`)
+	 * \return number of missing genotypes
+	 */
+	uint32_t countMissingGenotypes(const char *samples, const size_t &nBytes, vector<uint64_t> *missing = nullptr);
+}
+
+#endif /* simdKernels_hpp */
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Site records and sinks
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Implementation of buffered file sinks for divergent and polymorphic sites.
+ *
+ */
+
+#include <string>
+#include <vector>
+
+#include "siteRecords.hpp"
+#include "tsvWriter.hpp"
+
+using std::string;
+using std::vector;
+
+using namespace BayesicSpace;
+
+SiteFile::SiteFile(const string &fileName, const vector<string> &chromosomes) : outFile_(fileName), chromosomes_{chromosomes}, prefix_{""}, queryStem_{""} {}
+
+void SiteFile::putLine(const string &line){
+	outFile_.putText(line);
+	outFile_.newLine();
+}
+
+void DivergedSiteFile::put(const DivergedSite &site){
+	outFile_.putText(prefix_);
+	putFields_(site);
+}
+
+void DivergedSiteFile::put(const DivergedSite &site, const size_t &query){
+	if ( queryStem_.empty() ) {
+		outFile_.putText(prefix_);
+	} else {
+		outFile_.putText(queryStem_);
+		outFile_.putUnsigned(query + 1);
+		outFile_.tab();
+	}
+	if ( !queryLengths_.empty() ) {
+		outFile_.putUnsigned(queryLengths_[query]);
+		outFile_.tab();
+	}
+	putFields_(site);
+}
+
+void DivergedSiteFile::putFields_(const DivergedSite &site){
+	outFile_.putText(chromosomes_[site.chromosome]);
+	outFile_.tab();
+	outFile_.putUnsigned(site.position);
+	outFile_.tab();
+	outFile_.putChar(site.primary);
+	outFile_.tab();
+	outFile_.putChar(site.aligned);
+	outFile_.tab();
+	outFile_.putUnsigned(site.sameChr);
+	outFile_.tab();
+	outFile_.putUnsigned(site.goodQuality);
+	outFile_.newLine();
+}
+
+void PolySiteFile::put(const PolySite &site){
+	outFile_.putText(prefix_);
+	putFields_(site);
+}
+
+void PolySiteFile::put(const PolySite &site, const size_t &query){
+	if ( queryStem_.empty() ) {
+		outFile_.putText(prefix_);
+	} else {
+		outFile_.putText(queryStem_);
+		outFile_.putUnsigned(query + 1);
+		outFile_.tab();
+	}
+	putFields_(site);
+}
+
+void PolySiteFile::putFields_(const PolySite &site){
+	outFile_.putText(chromosomes_[site.chromosome]);
+	outFile_.tab();
+	outFile_.putUnsigned(site.position);
+	outFile_.tab();
+	outFile_.putChar(site.reference);
+	outFile_.tab();
+	outFile_.putChar(site.alternative);
+	outFile_.tab();
+	outFile_.putChar(site.ancestral);
+	outFile_.tab();
+	outFile_.putUnsigned(site.derivedAC);
+	outFile_.tab();
+	outFile_.putUnsigned(site.derivedMLAC);
+	outFile_.tab();
+	outFile_.putFixed(site.derivedAF, 6);
+	outFile_.tab();
+	outFile_.putFixed(site.derivedMLAF, 6);
+	outFile_.tab();
+	outFile_.putUnsigned(site.numMissing);
+	outFile_.tab();
+	outFile_.putUnsigned(site.sameChr);
+	outFile_.tab();
+	outFile_.putUnsigned(site.outgroupQuality);
+	outFile_.tab();
+	outFile_.putDefault(site.quality);
+	outFile_.newLine();
+}
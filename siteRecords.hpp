@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Site records and sinks
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Definitions and interface documentation for divergent and polymorphic site records, the sink interface parsers push them into, and buffered file sinks that format them.
+ *
+ */
+
+#ifndef siteRecords_hpp
+#define siteRecords_hpp
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "tsvWriter.hpp"
+
+using std::string;
+using std::vector;
+
+namespace BayesicSpace {
+	/** \brief Divergent site
+	 *
+	 * Describes a site where the primary and aligned nucleotides differ.
+	 */
+	struct DivergedSite {
+		/// Chromosome index (see `ParseAXT::chromosomeNames()`)
+		uint32_t chromosome;
+		/// Position in the primary sequence
+		uint64_t position;
+		/// Primary nucleotide
+		char primary;
+		/// Aligned nucleotide
+		char aligned;
+		/// Is the aligned nucleotide on the same chromosome (1 for yes, 0 for no)?
+		uint16_t sameChr;
+		/// Are both nucleotides in upper case, indicating high quality base calls (1 for yes, 0 for no)?
+		uint16_t goodQuality;
+	};
+
+	/** \brief Polymorphic site
+	 *
+	 * Describes a biallelic SNP, with allele counts and frequencies polarized by the outgroup: if the alternative allele is ancestral, the counts and frequencies are those of the reference allele.
+	 */
+	struct PolySite {
+		/// Chromosome index (see `ParseVCF::chromosomeNames()`)
+		uint32_t chromosome;
+		/// Position
+		uint64_t position;
+		/// Reference nucleotide
+		char reference;
+		/// Alternative nucleotide
+		char alternative;
+		/// Which nucleotide is ancestral ('r' for reference, 'a' alternative, 'u' unknown)
+		char ancestral;
+		/// Derived allele count
+		uint32_t derivedAC;
+		/// Derived allele count (maximum likelihood)
+		uint32_t derivedMLAC;
+		/// Derived allele frequency
+		double derivedAF;
+		/// Derived allele frequency (maximum likelihood)
+		double derivedMLAF;
+		/// Number of missing genotypes
+		uint32_t numMissing;
+		/// Is the outgroup nucleotide on the same chromosome as the polymorphic site (1 for yes, 0 for no)?
+		uint16_t sameChr;
+		/// Is the outgroup nucleotide good quality (1 for yes, 0 for no)?
+		uint16_t outgroupQuality;
+		/// Site quality score
+		double quality;
+	};
+
+	/** \brief Divergent site sink
+	 *
+	 * Parsers push each divergent site into a sink as soon as it is found.
+	 */
+	class DivergedSiteSink {
+		public:
+			/** \brief Destructor */
+			virtual ~DivergedSiteSink(){};
+			/** \brief Accept a site
+			 *
+			 * \param[in] site divergent site
+			 */
+			virtual void put(const DivergedSite &site) = 0;
+			/** \brief Accept a site found by a query
+			 *
+			 * Used by searches that handle many queries at once. By default the query is ignored.
+			 *
+			 * \param[in] site divergent site
+			 * \param[in] query index of the query the site was found by
+			 */
+			virtual void put(const DivergedSite &site, const size_t & /* query */) { put(site); };
+	};
+
+	/** \brief Polymorphic site sink
+	 *
+	 * Parsers push each polymorphic site into a sink as soon as it is found.
+	 */
+	class PolySiteSink {
+		public:
+			/** \brief Destructor */
+			virtual ~PolySiteSink(){};
+			/** \brief Accept a site
+			 *
+			 * \param[in] site polymorphic site
+			 */
+			virtual void put(const PolySite &site) = 0;
+			/** \brief Accept a site found by a query
+			 *
+			 * Used by searches that handle many queries at once. By default the query is ignored.
+			 *
+			 * \param[in] site polymorphic site
+			 * \param[in] query index of the query the site was found by
+			 */
+			virtual void put(const PolySite &site, const size_t & /* query */) { put(site); };
+	};
+
+	/** \brief Buffered site file
+	 *
+	 * Base for file sinks: owns a buffered writer, so that lines are written in big blocks rather than one at a time.
+	 * Each site line may start with a prefix (e.g., a peak ID), which stays in effect until changed.
+	 */
+	class SiteFile {
+		public:
+			/** \brief Constructor
+			 *
+			 * Opens (and truncates) the output file.
+			 *
+			 * \param[in] fileName output file name
+			 * \param[in] chromosomes chromosome names, indexed by the site record chromosome index
+			 */
+			SiteFile(const string &fileName, const vector<string> &chromosomes);
+			/** \brief Destructor */
+			virtual ~SiteFile(){};
+			/// Copy constructor
+			SiteFile(const SiteFile &in) = delete;
+			/// Copy assignment
+			SiteFile &operator=(const SiteFile &in) = delete;
+
+			/** \brief Write a line as is
+			 *
+			 * For headers and meta-data. The line end is added.
+			 *
+			 * \param[in] line line to write
+			 */
+			void putLine(const string &line);
+			/** \brief Set the line prefix
+			 *
+			 * \param[in] prefix text written at the start of each following site line
+			 */
+			void setPrefix(const string &prefix) { prefix_ = prefix; };
+			/** \brief Set the query ID prefix
+			 *
+			 * Sites that come with a query index start with the stem followed by the query index plus one and a tab (e.g., "P3\t" for the third query with stem "P"), in place of the line prefix.
+			 *
+			 * \param[in] stem query ID stem
+			 */
+			void setQueryPrefix(const string &stem) { queryStem_ = stem; };
+			/** \brief Flush and close the file */
+			void close() { outFile_.close(); };
+		protected:
+			/// Output writer
+			TSVwriter outFile_;
+			/// Chromosome names
+			const vector<string> &chromosomes_;
+			/// Line prefix
+			string prefix_;
+			/// Query ID stem (empty if query indexes are not written)
+			string queryStem_;
+	};
+
+	/** \brief Divergent site file
+	 *
+	 * Writes one tab-delimited line per site with the following fields:
+	 *
+	 * - chromosome name
+	 * - position
+	 * - primary nucleotide
+	 * - aligned nucleotide
+	 * - whether the aligned nucleotide is on the same chromosome
+	 * - whether both nucleotides are in upper case (indicating high quality base calls)
+	 */
+	class DivergedSiteFile : public DivergedSiteSink, public SiteFile {
+		public:
+			/** \brief Constructor
+			 *
+			 * \param[in] fileName output file name
+			 * \param[in] chromosomes chromosome names, indexed by the site record chromosome index
+			 */
+			DivergedSiteFile(const string &fileName, const vector<string> &chromosomes) : SiteFile(fileName, chromosomes) {};
+			/** \brief Set query lengths
+			 *
+			 * If set, sites that come with a query index have the length of their query written after the query ID.
+			 *
+			 * \param[in] lengths length of each query, indexed by query
+			 */
+			void setQueryLengths(const vector<uint64_t> &lengths) { queryLengths_ = lengths; };
+			/** \brief Write a site
+			 *
+			 * \param[in] site divergent site
+			 */
+			void put(const DivergedSite &site) override;
+			/** \brief Write a site found by a query
+			 *
+			 * \param[in] site divergent site
+			 * \param[in] query index of the query the site was found by
+			 */
+			void put(const DivergedSite &site, const size_t &query) override;
+		private:
+			/// Query lengths (empty if not written)
+			vector<uint64_t> queryLengths_;
+			/** \brief Write the site fields
+			 *
+			 * \param[in] site divergent site
+			 */
+			void putFields_(const DivergedSite &site);
+	};
+
+	/** \brief Polymorphic site file
+	 *
+	 * Writes one tab-delimited line per site with the following fields:
+	 *
+	 * - chromosome name
+	 * - position
+	 * - reference nucleotide
+	 * - alternative nucleotide
+	 * - which nucleotide is ancestral ('r' for reference, 'a' alternative, 'u' unknown)
+	 * - derived allele count
+	 * - derived allele count (maximum likelihood)
+	 * - derived allele frequency (six decimal places)
+	 * - derived allele frequencey (maximum likelihood; six decimal places)
+	 * - number of missing genotypes
+	 * - whether the outgroup nucleotide is on the same chromosome as the polymorphic site
+	 * - whether the outgroup nucleotide is good quality
+	 * - site quality score (default stream format, e.g., 1030.51 or 0.004)
+	 */
+	class PolySiteFile : public PolySiteSink, public SiteFile {
+		public:
+			/** \brief Constructor
+			 *
+			 * \param[in] fileName output file name
+			 * \param[in] chromosomes chromosome names, indexed by the site record chromosome index
+			 */
+			PolySiteFile(const string &fileName, const vector<string> &chromosomes) : SiteFile(fileName, chromosomes) {};
+			/** \brief Write a site
+			 *
+			 * \param[in] site polymorphic site
+			 */
+			void put(const PolySite &site) override;
+			/** \brief Write a site found by a query
+			 *
+			 * \param[in] site polymorphic site
+			 * \param[in] query index of the query the site was found by
+			 */
+			void put(const PolySite &site, const size_t &query) override;
+		private:
+			/** \brief Write the site fields
+			 *
+			 * \param[in] site polymorphic site
+			 */
+			void putFields_(const PolySite &site);
+	};
+}
+
+#endif /* siteRecords_hpp */
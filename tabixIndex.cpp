@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Tabix and CSI indexes
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Implementation of tabix (.tbi) and CSI (.csi) index reading and region queries.
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+#include <algorithm>
+#include <cstdint>
+
+#include "tabixIndex.hpp"
+#include "bgzfFile.hpp"
+#include "genomeDictionary.hpp"
+
+using std::string;
+using std::vector;
+using std::unordered_map;
+
+using namespace BayesicSpace;
+
+/** \brief Read a little-endian integer
+ *
+ * \param[in] contents index file contents
+ * \param[in,out] position position of the integer; moved past it
+ * \return the value
+ */
+template <typename T>
+static T readInteger(const vector<char> &contents, size_t &position){
+	if (position + sizeof(T) > contents.size()) {
+		throw string("ERROR: index file is truncated");
+	}
+	uint64_t value = 0;
+	for (size_t iByte = 0; iByte < sizeof(T); iByte++) {
+		value |= static_cast<uint64_t>( static_cast<unsigned char>(contents[position + iByte]) ) << (8*iByte);
+	}
+	position += sizeof(T);
+	return static_cast<T>(value);
+}
+
+TabixIndex::TabixIndex(const string &indexFileName) : minShift_{14}, depth_{5} {
+	BGZFfile indexFile(indexFileName);
+	vector<char> contents;
+	const size_t readSize = 65536;
+	size_t nRead          = 0;
+	do {
+		contents.resize(contents.size() + readSize);
+		nRead = indexFile.read(contents.data() + contents.size() - readSize, readSize);
+		contents.resize(contents.size() - readSize + nRead);
+	} while (nRead == readSize);
+
+	if (contents.size() < 4) {
+		throw string("ERROR: index file ") + indexFileName + string(" is too short");
+	}
+	size_t position = 4;
+	const bool isCSI = (memcmp(contents.data(), "CSI\1", 4) == 0);
+	if ( !isCSI && (memcmp(contents.data(), "TBI\1", 4) != 0) ) {
+		throw string("ERROR: ") + indexFileName + string(" is not a tabix or CSI index");
+	}
+	if (isCSI) {
+		minShift_ = readInteger<int32_t>(contents, position);
+		depth_    = readInteger<int32_t>(contents, position);
+		const size_t auxLength = static_cast<size_t>( readInteger<int32_t>(contents, position) );
+		if ( (auxLength < 28) || (position + auxLength > contents.size()) ) {
+			throw string("ERROR: CSI index ") + indexFileName + string(" has no sequence names");
+		}
+		size_t auxPosition = position + 24; // skip format, column, and meta-character fields
+		const size_t namesLength = static_cast<size_t>( readInteger<int32_t>(contents, auxPosition) );
+		if (auxPosition + namesLength > position + auxLength) {
+			throw string("ERROR: malformed sequence names in CSI index ") + indexFileName;
+		}
+		readNames_(contents.data() + auxPosition, namesLength);
+		position += auxLength;
+	}
+	const size_t nReferences = static_cast<size_t>( readInteger<int32_t>(contents, position) );
+	if (!isCSI) {
+		position += 24; // skip format, column, and meta-character fields
+		const size_t namesLength = static_cast<size_t>( readInteger<int32_t>(contents, position) );
+		if (position + namesLength > contents.size()) {
+			throw string("ERROR: index file is truncated");
+		}
+		readNames_(contents.data() + position, namesLength);
+		position += namesLength;
+	}
+	if (nReferences != references_.size()) {
+		throw string("ERROR: number of sequence names does not match the number of indexed sequences in ") + indexFileName;
+	}
+	const uint32_t pseudoBin = nBins_() + 1; // holds meta-data rather than records
+	for (auto &ref : references_) {
+		const int32_t nBins = readInteger<int32_t>(contents, position);
+		for (int32_t iBin = 0; iBin < nBins; iBin++) {
+			const uint32_t bin = readInteger<uint32_t>(contents, position);
+			uint64_t binOffset = 0;
+			if (isCSI) {
+				binOffset = readInteger<uint64_t>(contents, position);
+			}
+			const int32_t nChunks = readInteger<int32_t>(contents, position);
+			vector<IndexChunk> chunks;
+			for (int32_t iChunk = 0; iChunk < nChunks; iChunk++) {
+				IndexChunk chunk;
+				chunk.begin = readInteger<uint64_t>(contents, position);
+				chunk.end   = readInteger<uint64_t>(contents, position);
+				chunks.push_back(chunk);
+			}
+			if (bin == pseudoBin) {
+				continue;
+			}
+			ref.bins[bin] = chunks;
+			if (isCSI) {
+				ref.binOffsets[bin] = binOffset;
+			}
+		}
+		if (!isCSI) {
+			const int32_t nWindows = readInteger<int32_t>(contents, position);
+			ref.linear.resize( static_cast<size_t>(nWindows) );
+			for (auto &w : ref.linear) {
+				w = readInteger<uint64_t>(contents, position);
+			}
+		}
+	}
+}
+
+bool TabixIndex::firstOffset(const string &chromName, const uint64_t &start, const uint64_t &end, uint64_t &offset) const {
+	auto chrIt = chromIndex_.find(chromName);
+	if ( chrIt == chromIndex_.end() ) {
+		return false;
+	}
+	const Reference &ref = references_[chrIt->second];
+	// switch to the zero-based half-open coordinates of the binning scheme
+	const uint64_t maxCoordinate = static_cast<uint64_t>(1) << (minShift_ + 3*depth_);
+	const uint64_t regionBeg     = std::min( (start ? start - 1 : 0), maxCoordinate - 1 );
+	const uint64_t regionEnd     = std::min( std::max(end, regionBeg + 1), maxCoordinate );
+
+	// records that end before the region cannot start past this offset
+	uint64_t minOffset = 0;
+	if ( !ref.linear.empty() ) {
+		const size_t window = std::min(static_cast<size_t>(regionBeg >> 14), ref.linear.size() - 1);
+		minOffset = ref.linear[window];
+	} else if ( !ref.binOffsets.empty() ) {
+		uint64_t bin = ( ( static_cast<uint64_t>(1) << (3*depth_) ) - 1 )/7 + (regionBeg >> minShift_); // smallest bin holding the region start
+		while (true) {
+			auto binIt = ref.binOffsets.find( static_cast<uint32_t>(bin) );
+			if ( binIt != ref.binOffsets.end() ) {
+				minOffset = binIt->second;
+				break;
+			}
+			if (bin == 0) {
+				break;
+			}
+			bin = (bin - 1) >> 3;
+		}
+	}
+
+	bool found = false;
+	offset     = UINT64_MAX;
+	for (int32_t level = 0; level <= depth_; level++) {
+		const uint64_t firstBin = ( ( static_cast<uint64_t>(1) << (3*level) ) - 1 )/7;
+		const int32_t shift     = minShift_ + 3*(depth_ - level);
+		const uint64_t binBeg   = firstBin + (regionBeg >> shift);
+		const uint64_t binEnd   = firstBin + ( (regionEnd - 1) >> shift );
+		for (uint64_t bin = binBeg; bin <= binEnd; bin++) {
+			auto binIt = ref.bins.find( static_cast<uint32_t>(bin) );
+			if ( binIt == ref.bins.end() ) {
+				continue;
+			}
+			for (auto &chunk : binIt->second) {
+				if (chunk.end > minOffset) {
+					found  = true;
+					offset = std::min( offset, std::max(chunk.begin, minOffset) );
+				}
+			}
+		}
+	}
+	return found;
+}
+
+void TabixIndex::readNames_(const char *names, const size_t &nBytes){
+	size_t position = 0;
+	while (position < nBytes) {
+		const size_t length = strnlen(names + position, nBytes - position);
+		chromIndex_[GenomeDictionary::canonicalName(names + position, length)] = references_.size();
+		references_.push_back( Reference() );
+		position += length + 1;
+	}
+}
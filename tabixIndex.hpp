@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Tabix and CSI indexes
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Class definitions and interface documentation for reading tabix (.tbi) and CSI (.csi) indexes of BGZF-compressed files.
+ *
+ */
+
+#ifndef tabixIndex_hpp
+#define tabixIndex_hpp
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+using std::string;
+using std::vector;
+using std::unordered_map;
+
+namespace BayesicSpace {
+	/** \brief Index chunk
+	 *
+	 * A range of BGZF virtual offsets holding records that belong to one bin.
+	 */
+	struct IndexChunk {
+		/// Virtual offset of the first record
+		uint64_t begin;
+		/// Virtual offset past the last record
+		uint64_t end;
+	};
+
+	/** \brief Tabix or CSI index
+	 *
+	 * Reads the binning index of a BGZF-compressed, coordinate-sorted file.
+	 * Both formats assign records to a hierarchy of bins; tabix uses a fixed scheme (16 kb smallest bins, five levels) and adds a linear index, while CSI stores the scheme in the file.
+	 * Chromosome names are normalized the same way as in the query files: names of one or two characters get a "chr" prefix.
+	 */
+	class TabixIndex {
+		public:
+			/** \brief Default constructor */
+			TabixIndex() : minShift_{14}, depth_{5} {};
+			/** \brief File name constructor
+			 *
+			 * The format is detected from the magic number.
+			 *
+			 * \param[in] indexFileName index file name
+			 */
+			TabixIndex(const string &indexFileName);
+
+			/** \brief Destructor */
+			~TabixIndex(){};
+			/// Copy constructor
+			TabixIndex(const TabixIndex &in) = delete;
+			/// Move constructor
+			TabixIndex(TabixIndex &&in) = default;
+			/// Copy assignment
+			TabixIndex &operator=(const TabixIndex &in) = delete;
+			/// Move assignment
+			TabixIndex &operator=(TabixIndex &&in) = default;
+
+			/** \brief Is the index loaded?
+			 *
+			 * \return true if an index has been read
+			 */
+			bool loaded() const { return !references_.empty(); };
+			/** \brief First offset for a region
+			 *
+			 * Finds the smallest virtual offset from which reading forward visits every record that overlaps the region.
+			 *
+			 * \param[in] chromName chromosome name
+			 * \param[in] start first position of the region (1-based)
+			 * \param[in] end last position of the region (1-based, inclusive)
+			 * \param[out] offset virtual offset to seek to
+			 * \return false if no records can overlap the region
+			 */
+			bool firstOffset(const string &chromName, const uint64_t &start, const uint64_t &end, uint64_t &offset) const;
+		private:
+			/// Per-chromosome index data
+			struct Reference {
+				/// Chunks in each bin
+				unordered_map<uint32_t, vector<IndexChunk>> bins;
+				/// Smallest record offset in each bin (CSI only)
+				unordered_map<uint32_t, uint64_t> binOffsets;
+				/// Smallest record offset in each 16 kb window (tabix only)
+				vector<uint64_t> linear;
+			};
+			/// Smallest bin size as a power of two
+			int32_t minShift_;
+			/// Number of bin levels below the root
+			int32_t depth_;
+			/// Chromosome index by name
+			unordered_map<string, size_t> chromIndex_;
+			/// Index data, one element per chromosome
+			vector<Reference> references_;
+
+			/** \brief Read chromosome names
+			 *
+			 * Parses the concatenated zero-terminated names of a tabix-style header.
+			 *
+			 * \param[in] names start of the names
+			 * \param[in] nBytes length of the name block
+			 */
+			void readNames_(const char *names, const size_t &nBytes);
+			/** \brief Number of bins
+			 *
+			 * \return total number of real bins for the index scheme
+			 */
+			uint32_t nBins_() const { return static_cast<uint32_t>( ( ( static_cast<uint64_t>(1) << (3*(depth_ + 1)) ) - 1 )/7 ); };
+	};
+}
+
+#endif /* tabixIndex_hpp */
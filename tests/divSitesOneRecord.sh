@@ -0,0 +1,30 @@
+#!/bin/sh
+#
+# Checks that divSites reads an AXT file with a single alignment record when the block index is built in memory (no .axti file).
+#
+# The record has two diverged sites (positions 4 and 9). Both the positions and the ranges query modes are run.
+#
+# Usage: divSitesOneRecord.sh path_to_divSites
+
+DIVSITES=${1:-./divSites}
+WORKDIR=$(mktemp -d "${TMPDIR:-/tmp}/divSitesOneRecord.XXXXXX") || exit 1
+trap 'rm -rf "$WORKDIR"' EXIT
+
+printf '0 chr2L 1 10 chr2L 1 10 + 5000\nACGTACGTAC\nACGAACGTTC\n\n' > "$WORKDIR/one.axt"
+printf 'chr\tpos\nchr2L\t4\nchr2L\t5\nchr2L\t9\n' > "$WORKDIR/positions.txt"
+printf 'chr\tstart\tend\nchr2L\t2\t9\n' > "$WORKDIR/ranges.txt"
+
+"$DIVSITES" -q "$WORKDIR/positions.txt" -a "$WORKDIR/one.axt" -o "$WORKDIR/positions.out" || exit 1
+printf '#\tchr2L\t3\nchr\tposition\tprNuc\talNuc\tsameCHR\tgoodQual\nchr2L\t4\tT\tA\t1\t1\nchr2L\t9\tA\tT\t1\t1\n' > "$WORKDIR/positions.expected"
+if ! cmp -s "$WORKDIR/positions.out" "$WORKDIR/positions.expected"; then
+	echo "divSites: unexpected positions output for a single-record alignment"
+	exit 1
+fi
+
+"$DIVSITES" -q "$WORKDIR/ranges.txt" -a "$WORKDIR/one.axt" -o "$WORKDIR/ranges.out" || exit 1
+printf 'peakID\trealLen\tchr\tposition\tprNuc\talNuc\tsameCHR\tgoodQual\nP1\t8\tchr2L\t4\tT\tA\t1\t1\nP1\t8\tchr2L\t9\tA\tT\t1\t1\n' > "$WORKDIR/ranges.expected"
+if ! cmp -s "$WORKDIR/ranges.out" "$WORKDIR/ranges.expected"; then
+	echo "divSites: unexpected ranges output for a single-record alignment"
+	exit 1
+fi
+echo "divSites: single-record alignment read in both query modes"
@@ -0,0 +1,71 @@
+#!/bin/sh
+#
+# Checks that polySites writes the same output with one and with several threads.
+#
+# Generates an AXT alignment, a VCF file big enough to be split into several chunks by the parallel scan, and a positions query file.
+# Some VCF records lack AC, AN, MLEAC, or MLEAF in their INFO fields, so values carried over from a previous record would show up as differences.
+#
+# Usage: polySitesThreads.sh path_to_polySites
+
+POLYSITES=${1:-./polySites}
+WORKDIR=$(mktemp -d "${TMPDIR:-/tmp}/polySitesThreads.XXXXXX") || exit 1
+trap 'rm -rf "$WORKDIR"' EXIT
+
+awk 'BEGIN {
+	srand(17);
+	split("A C G T", nuc, " ");
+	chrLength = 200000;
+	recLength = 5000;
+	print "##matrix=axtChain 16 91,-114,-31,-123";
+	for (iRec = 0; iRec * recLength < chrLength; iRec++) {
+		start = iRec * recLength + 1;
+		end   = start + recLength - 1;
+		primary = ""; aligned = "";
+		for (i = 0; i < recLength; i++) {
+			p = nuc[int(rand() * 4) + 1];
+			a = (rand() < 0.05 ? nuc[int(rand() * 4) + 1] : p);
+			primary = primary p; aligned = aligned a;
+		}
+		print iRec, "chr2L", start, end, "chr2L", start, end, "+", 5000;
+		print primary; print aligned; print "";
+	}
+}' > "$WORKDIR/test.axt"
+
+awk 'BEGIN {
+	srand(29);
+	split("A C G T", nuc, " ");
+	nSamples = 40;
+	print "##fileformat=VCFv4.1";
+	header = "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT";
+	for (i = 0; i < nSamples; i++) header = header "\ts" i;
+	print header;
+	print "chr\tpos" > "'"$WORKDIR"'/positions.txt";
+	for (pos = 2; pos < 195000; pos += 3) {
+		ref = int(rand() * 4) + 1;
+		alt = (ref % 4) + 1;
+		line = "2L\t" pos "\t.\t" nuc[ref] "\t" nuc[alt] "\t" sprintf("%.3f", rand() * 100) "\tPASS\t";
+		ac = int(rand() * 60); an = 80;
+		info = "DP=300";
+		if (rand() < 0.7) info = info ";AC=" ac;
+		if (rand() < 0.7) info = info ";AF=" sprintf("%.3f", ac / an);
+		if (rand() < 0.7) info = info ";AN=" an;
+		if (rand() < 0.7) info = info ";MLEAC=" ac;
+		if (rand() < 0.7) info = info ";MLEAF=" sprintf("%.3f", ac / an);
+		line = line info "\tGT";
+		for (i = 0; i < nSamples; i++) {
+			r = rand();
+			line = line (r < 0.1 ? "\t./." : (r < 0.5 ? "\t0/0" : (r < 0.8 ? "\t0/1" : "\t1/1")));
+		}
+		print line;
+		print "chr2L\t" pos > "'"$WORKDIR"'/positions.txt";
+	}
+}' > "$WORKDIR/test.vcf"
+
+"$POLYSITES" -q "$WORKDIR/positions.txt" -a "$WORKDIR/test.axt" -v "$WORKDIR/test.vcf" -o "$WORKDIR/one.txt" -t 1 || exit 1
+"$POLYSITES" -q "$WORKDIR/positions.txt" -a "$WORKDIR/test.axt" -v "$WORKDIR/test.vcf" -o "$WORKDIR/four.txt" -t 4 || exit 1
+if cmp -s "$WORKDIR/one.txt" "$WORKDIR/four.txt"; then
+	echo "polySites: one and four threads agree ($(wc -l < "$WORKDIR/one.txt") lines)"
+else
+	echo "polySites: output with four threads differs from output with one thread"
+	exit 1
+fi
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Buffered tab-delimited output
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Implementation of a buffered writer of tab-delimited text files.
+ *
+ */
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <system_error>
+
+#include "tsvWriter.hpp"
+
+using std::fstream;
+using std::string;
+using std::vector;
+using std::system_error;
+using std::ios;
+
+using namespace BayesicSpace;
+
+/// Powers of ten used to scale fixed-point values
+static const uint64_t powersOfTen[] = {1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL};
+
+TSVwriter::TSVwriter(const string &fileName) : buffer_(4194304), used_{0} {
+	try {
+		outFile_.exceptions(fstream::badbit | fstream::failbit);
+		outFile_.open(fileName.c_str(), ios::out | ios::trunc | ios::binary);
+	} catch(system_error &error) {
+		string message = "ERROR: cannot open file " + fileName + " to write: " + error.code().message();
+		throw message;
+	}
+}
+
+TSVwriter::~TSVwriter(){
+	if ( outFile_.is_open() ) {
+		outFile_.exceptions(fstream::goodbit); // cannot throw from a destructor
+		flush_();
+		outFile_.close();
+	}
+}
+
+void TSVwriter::putBytes(const char *bytes, const size_t &nBytes){
+	if (nBytes > buffer_.size() - used_) {
+		flush_();
+		if ( nBytes >= buffer_.size() ) { // too big to be worth copying
+			outFile_.write( bytes, static_cast<std::streamsize>(nBytes) );
+			return;
+		}
+	}
+	memcpy(buffer_.data() + used_, bytes, nBytes);
+	used_ += nBytes;
+}
+
+void TSVwriter::putUnsigned(uint64_t value){
+	char digits[20]; // enough for the largest uint64_t
+	char *start = digits + sizeof(digits);
+	do {
+		*(--start) = static_cast<char>('0' + value % 10);
+		value     /= 10;
+	} while (value);
+	putBytes( start, static_cast<size_t>(digits + sizeof(digits) - start) );
+}
+
+void TSVwriter::putFixed(const double &value, const uint16_t &decimals){
+	if (decimals > 9) {
+		throw string("ERROR: at most nine decimal places are supported in TSVwriter::putFixed()");
+	}
+	double magnitude = fabs(value);
+	double scaled    = magnitude * static_cast<double>(powersOfTen[decimals]) + 0.5;
+	if ( !std::isfinite(scaled) || (scaled >= 9.0e18) ) { // out of integer range; let the C library deal with it
+		char text[512];
+		int nChar = snprintf(text, sizeof(text), "%.*f", static_cast<int>(decimals), value);
+		putBytes( text, static_cast<size_t>(nChar) );
+		return;
+	}
+	uint64_t rounded = static_cast<uint64_t>(scaled);
+	if ( std::signbit(value) ) {
+		putChar('-');
+	}
+	putUnsigned(rounded / powersOfTen[decimals]);
+	if (decimals) {
+		putChar('.');
+		uint64_t fraction = rounded % powersOfTen[decimals];
+		char digits[9];
+		for (uint16_t iDig = decimals; iDig > 0; iDig--) {
+			digits[iDig - 1] = static_cast<char>('0' + fraction % 10);
+			fraction        /= 10;
+		}
+		putBytes(digits, decimals);
+	}
+}
+
+void TSVwriter::putDefault(const double &value){
+	char text[32];
+	int nChar = snprintf(text, sizeof(text), "%g", value);
+	putBytes( text, static_cast<size_t>(nChar) );
+}
+
+void TSVwriter::close(){
+	if ( outFile_.is_open() ) {
+		flush_();
+		outFile_.close();
+	}
+}
+
+void TSVwriter::flush_(){
+	if (used_) {
+		outFile_.write( buffer_.data(), static_cast<std::streamsize>(used_) );
+		used_ = 0;
+	}
+}
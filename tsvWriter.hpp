@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2019 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Buffered tab-delimited output
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2019 Anthony J. Greenberg
+ * \version 0.1
+ *
+ * Class definition and interface documentation for a buffered writer of tab-delimited text files.
+ *
+ */
+
+#ifndef tsvWriter_hpp
+#define tsvWriter_hpp
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+using std::fstream;
+using std::string;
+using std::vector;
+
+namespace BayesicSpace {
+	/** \brief Buffered text file writer
+	 *
+	 * Accumulates output in a large user-space buffer and writes it to the file in big blocks, so there is no per-line flush.
+	 * Numbers are formatted directly into the buffer without going through stream locales.
+	 * Integers are written exactly as `operator<<` would write them.
+	 * Floating-point values are written either with a fixed number of decimal places, rounded half up, or in the default stream format.
+	 */
+	class TSVwriter {
+		public:
+			/** \brief Constructor
+			 *
+			 * Opens (and truncates) the output file.
+			 *
+			 * \param[in] fileName output file name
+			 */
+			TSVwriter(const string &fileName);
+			/** \brief Destructor
+			 *
+			 * Writes out any buffered text.
+			 */
+			~TSVwriter();
+			/// Copy constructor
+			TSVwriter(const TSVwriter &in) = delete;
+			/// Copy assignment
+			TSVwriter &operator=(const TSVwriter &in) = delete;
+
+			/** \brief Write text
+			 *
+			 * \param[in] text text to write
+			 */
+			void putText(const string &text) { putBytes( text.data(), text.size() ); };
+			/** \brief Write raw bytes
+			 *
+			 * \param[in] bytes pointer to the first byte
+			 * \param[in] nBytes number of bytes
+			 */
+			void putBytes(const char *bytes, const size_t &nBytes);
+			/** \brief Write a character
+			 *
+			 * \param[in] character character to write
+			 */
+			void putChar(const char &character) { if (used_ == buffer_.size()) flush_(); buffer_[used_++] = character; };
+			/** \brief Write a tab */
+			void tab() { putChar('\t'); };
+			/** \brief End the line */
+			void newLine() { putChar('\n'); };
+			/** \brief Write an unsigned integer
+			 *
+			 * \param[in] value value to write
+			 */
+			void putUnsigned(uint64_t value);
+			/** \brief Write a floating-point number in fixed notation
+			 *
+			 * \param[in] value value to write
+			 * \param[in] decimals number of digits after the decimal point (at most 9)
+			 */
+			void putFixed(const double &value, const uint16_t &decimals);
+			/** \brief Write a floating-point number in the default format
+			 *
+			 * Writes the value as `operator<<` would with default stream settings (six significant digits, trailing zeros dropped, scientific notation for very large or small values).
+			 *
+			 * \param[in] value value to write
+			 */
+			void putDefault(const double &value);
+			/** \brief Write out buffered text and close the file */
+			void close();
+		private:
+			/// Output buffer
+			vector<char> buffer_;
+			/// Number of bytes used in the buffer
+			size_t used_;
+			/// Output file stream
+			fstream outFile_;
+
+			/** \brief Write the buffer to the file */
+			void flush_();
+	};
+}
+
+#endif /* tsvWriter_hpp */
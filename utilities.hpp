@@ -29,9 +29,15 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <unistd.h>
 
 using std::string;
 using std::unordered_map;
+using std::vector;
 
 namespace BayesicSpace {
 	/** \brief Parse command line flags
@@ -40,7 +46,7 @@ namespace BayesicSpace {
 	 * \param[in] argv array of argument values
 	 * \param[out] cli flag values, indexed by flag IDs
 	 */
-	void parseCL(int &argc, char **argv, unordered_map<char, string> &cli){
+	inline void parseCL(int &argc, char **argv, unordered_map<char, string> &cli){
 		// set to true after encountering a flag token (the character after the dash)
 		bool val = false;
 		// store the token value here
@@ -66,6 +72,62 @@ namespace BayesicSpace {
 
 		}
 	}
+	/** \brief Parse an unsigned integer in place
+	 *
+	 * Reads decimal digits starting at `start` and stops at the first non-digit character or at `end`, whichever comes first.
+	 * No characters are skipped, so `value` is 0 if `start` does not point to a digit.
+	 *
+	 * \param[in] start pointer to the first character
+	 * \param[in] end pointer to one past the last character that may be read
+	 * \param[out] value parsed value
+	 * \return pointer to the first character that is not part of the number
+	 */
+	inline const char *parseUnsigned(const char *start, const char *end, uint64_t &value){
+		value = 0;
+		while ( (start != end) && (*start >= '0') && (*start <= '9') ) {
+			value = 10*value + static_cast<uint64_t>(*start - '0');
+			++start;
+		}
+		return start;
+	}
+	/** \brief Temporary file
+	 *
+	 * Creates an empty file with a unique name and removes it when the object goes out of scope, including when an exception is thrown.
+	 */
+	class TemporaryFile {
+		public:
+			/** \brief Constructor
+			 *
+			 * The file name is the stem followed by a dot and six random characters.
+			 *
+			 * \param[in] stem file name stem (may include a directory)
+			 */
+			TemporaryFile(const string &stem) {
+				const string nameTemplate = stem + ".XXXXXX";
+				vector<char> name( nameTemplate.begin(), nameTemplate.end() );
+				name.push_back('\0');
+				const int fileDescriptor = mkstemp( name.data() );
+				if (fileDescriptor == -1) {
+					throw string("ERROR: failed to create a temporary file for ") + stem;
+				}
+				::close(fileDescriptor);
+				fileName_ = name.data();
+			};
+			/** \brief Destructor */
+			~TemporaryFile(){ std::remove( fileName_.c_str() ); };
+			/// Copy constructor
+			TemporaryFile(const TemporaryFile &in) = delete;
+			/// Copy assignment
+			TemporaryFile &operator=(const TemporaryFile &in) = delete;
+			/** \brief File name
+			 *
+			 * \return temporary file name
+			 */
+			const string &name() const { return fileName_; };
+		private:
+			/// File name
+			string fileName_;
+	};
 }
 #endif /* utilities_hpp */
 